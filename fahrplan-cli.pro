@@ -0,0 +1,39 @@
+# Headless command line client and local HTTP/JSON service, only links the
+# parser layer.
+# Build with: qmake fahrplan-cli.pro && make
+
+VERSION = 2.0.25
+TARGET = fahrplan-cli
+TEMPLATE = app
+
+MOC_DIR = tmp-cli
+OBJECTS_DIR = tmp-cli
+
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += FAHRPLAN_VERSION=\\\"$$VERSION\\\"
+greaterThan(QT_MAJOR_VERSION, 4) {
+    DEFINES += BUILD_FOR_QT5
+}
+
+INCLUDEPATH += src
+
+include(src/parser/parser.pri)
+
+HEADERS += \
+    src/fahrplan_parser_thread.h \
+    src/fahrplan_parser_reply.h \
+    src/cli/cli_json.h \
+    src/cli/cli_query.h \
+    src/cli/cli_runner.h \
+    src/cli/cli_server.h
+SOURCES += \
+    src/fahrplan_parser_thread.cpp \
+    src/fahrplan_parser_reply.cpp \
+    src/cli/cli_json.cpp \
+    src/cli/cli_query.cpp \
+    src/cli/cli_runner.cpp \
+    src/cli/cli_server.cpp \
+    src/cli/main.cpp
@@ -41,9 +41,9 @@ exists($$QMAKE_INCDIR_QT"/../qmsystem2/qmkeys.h"):!contains(MEEGO_EDITION,harmat
 # Additional import path used to resolve QML modules in Creator's code model
 QML_IMPORT_PATH =
 
-QT += network xml
+QT += network xml sql
 lessThan(QT_MAJOR_VERSION, 5) {
-    QT += declarative script
+    QT += declarative
 } else {
     QT += quick qml concurrent
     DEFINES += BUILD_FOR_QT5
@@ -85,72 +85,45 @@ RESOURCES += \
     translations_res.qrc
 
 INCLUDEPATH += src
-# Zlib todo for other systems ugly hack
-!unix: INCLUDEPATH += f:/QtSdk/Qt5.4.0/5.4/mingw491_32/include/QtZlib
-unix:!symbian: LIBS += -lz
 
 HEADERS += \
-    src/parser/parser_hafasxml.h \
-    src/parser/parser_abstract.h \
-    src/parser/parser_definitions.h \
-    src/parser/parser_xmlsbbch.h \
-    src/parser/parser_xmlrejseplanendk.h \
-    src/parser/parser_xmloebbat.h \
-    src/parser/parser_xmlvasttrafikse.h \
     src/fahrplan.h \
     src/fahrplan_backend_manager.h \
-    src/parser/parser_mobilebahnde.h \
+    src/fahrplan_federated_search.h \
+    src/fahrplan_settings.h \
+    src/fahrplan_stations_store.h \
+    src/fahrplan_startup.h \
     src/calendarthreadwrapper.h \
-    src/parser/parser_xmlnri.h \
-    src/parser/parser_hafasbinary.h \
     src/fahrplan_parser_thread.h \
+    src/fahrplan_parser_pool.h \
+    src/fahrplan_parser_reply.h \
     src/fahrplan_calendar_manager.h \
     src/models/stationslistmodel.h \
     src/models/favorites.h \
     src/models/stationsearchresults.h \
+    src/models/stationsuggestions.h \
     src/models/timetable.h \
-    src/models/trainrestrictions.h \
-    src/parser/parser_ptvvicgovau.h \
-    src/parser/parser_efa.h \
-    src/parser/parser_ireland_efa.h \
-    src/parser/parser_sydney_efa.h \
-    src/parser/parser_sf_bay_efa.h \
-    src/parser/parser_dubai_efa.h \
-    src/parser/parser_ninetwo.h \
-    src/parser/parser_munich_efa.h \
-    src/parser/parser_salzburg_efa.h \
-    src/parser/parser_resrobot.h
+    src/models/trainrestrictions.h
 SOURCES += src/main.cpp \
-    src/parser/parser_hafasxml.cpp \
-    src/parser/parser_abstract.cpp \
-    src/parser/parser_definitions.cpp \
-    src/parser/parser_xmlsbbch.cpp \
-    src/parser/parser_xmlrejseplanendk.cpp \
-    src/parser/parser_xmloebbat.cpp \
-    src/parser/parser_xmlvasttrafikse.cpp \
     src/fahrplan.cpp \
     src/fahrplan_backend_manager.cpp \
-    src/parser/parser_mobilebahnde.cpp \
+    src/fahrplan_federated_search.cpp \
+    src/fahrplan_settings.cpp \
+    src/fahrplan_stations_store.cpp \
+    src/fahrplan_startup.cpp \
     src/calendarthreadwrapper.cpp \
-    src/parser/parser_xmlnri.cpp \
-    src/parser/parser_hafasbinary.cpp \
     src/fahrplan_parser_thread.cpp \
+    src/fahrplan_parser_pool.cpp \
+    src/fahrplan_parser_reply.cpp \
     src/fahrplan_calendar_manager.cpp \
     src/models/stationslistmodel.cpp \
     src/models/favorites.cpp \
     src/models/stationsearchresults.cpp \
+    src/models/stationsuggestions.cpp \
     src/models/timetable.cpp \
-    src/models/trainrestrictions.cpp \
-    src/parser/parser_ptvvicgovau.cpp \
-    src/parser/parser_efa.cpp \
-    src/parser/parser_ireland_efa.cpp \
-    src/parser/parser_sydney_efa.cpp \
-    src/parser/parser_sf_bay_efa.cpp \
-    src/parser/parser_dubai_efa.cpp \
-    src/parser/parser_ninetwo.cpp \
-    src/parser/parser_munich_efa.cpp \
-    src/parser/parser_salzburg_efa.cpp \
-    src/parser/parser_resrobot.cpp
+    src/models/trainrestrictions.cpp
+
+include(src/parser/parser.pri)
 
 # This hack is needed for lupdate to pick up texts from QML files
 translate_hack {
@@ -20,8 +20,11 @@
 #include "calendarthreadwrapper.h"
 
 #include <QCoreApplication>
+#include <QFile>
+#include <QLocale>
+#include <QTextStream>
 #include <QThread>
-#include <QSettings>
+#include "fahrplan_settings.h"
 
 #ifdef BUILD_FOR_BLACKBERRY
 #   include <bb/pim/calendar/CalendarService>
@@ -37,30 +40,123 @@ QTM_USE_NAMESPACE
 #   include <extendedstorage.h>
 #   include <kdatetime.h>
 #   include <ksystemtimezone.h>
+#else
+#   include <QDebug>
+#   include <QDir>
+#   if defined(BUILD_FOR_QT5)
+#       include <QStandardPaths>
+#   else
+#       include <QDesktopServices>
+#   endif
 #endif
 
-QString formatStation(const QDateTime dateTime, const QString &stationName, const QString &info = QString())
+// iCalendar date-time in UTC
+static const char ICAL_DATE_TIME_FORMAT[] = "yyyyMMdd'T'HHmmss'Z'";
+
+namespace {
+
+// Builds titles and descriptions of calendar entries. Translations, locale
+// formats and settings are looked up once per batch, not per line.
+class CalendarEntryFormatter
 {
-    QString station;
-    if (info.isEmpty()) {
-        station = stationName;
-    } else {
-        //: STATION / PLATFORM
-        station = CalendarThreadWrapper::tr("%1 / %2", "STATION / PLATFORM").arg(stationName, info);
+public:
+    CalendarEntryFormatter()
+        : m_toFormat(CalendarThreadWrapper::tr("%1 to %2"))
+        , m_viaFormat(CalendarThreadWrapper::tr("%1 via %3 to %2"))
+          //: STATION / PLATFORM
+        , m_stationInfoFormat(CalendarThreadWrapper::tr("%1 / %2", "STATION / PLATFORM"))
+          //: DATE TIME   STATION
+        , m_lineFormat(CalendarThreadWrapper::tr("%1 %2   %3", "DATE TIME   STATION"))
+        , m_footer(CalendarThreadWrapper::tr("-- \nAdded by Fahrplan. Please, re-check the information before your journey."))
+          // TODO: Don't force QLocale::ShortFormat for date, but make it configurable.
+        , m_dateFormat(QLocale().dateFormat(QLocale::ShortFormat))
+          // Always use short format for time, else you get something like "12:35:00 t".
+        , m_timeFormat(QLocale().timeFormat(QLocale::ShortFormat))
+    {
+        m_compactFormat = FahrplanSettings::instance()->value("compactCalendarEntries", false).toBool();
+    }
+
+    template <class Journey>
+    QString title(const Journey &journey) const
+    {
+        if (journey.viaStation.isEmpty())
+            return m_toFormat.arg(journey.departureStation, journey.arrivalStation);
+        return m_viaFormat.arg(journey.departureStation, journey.arrivalStation, journey.viaStation);
     }
 
-    //: DATE TIME   STATION
-    return CalendarThreadWrapper::tr("%1 %2   %3", "DATE TIME   STATION").arg(
-               // TODO: Don't force QLocale::ShortFormat for date, but make it configurable.
-               dateTime.toString(QLocale().dateFormat(QLocale::ShortFormat)),
-               // Always use short format for time, else you get something like "12:35:00 t".
-               dateTime.toString(QLocale().timeFormat(QLocale::ShortFormat)),
-               station);
+    // Replaces the content of description, its buffer is kept, so passing
+    // the same string for every journey avoids reallocations.
+    template <class Journey>
+    void description(QString &description, const Journey &journey) const
+    {
+        description.resize(0);
+
+        if (!journey.info.isEmpty())
+            description.append(journey.info).append('\n');
+
+        for (int i = 0; i < journey.legs.count(); ++i)
+            appendLeg(description, journey.legs.at(i));
+
+        if (!m_compactFormat)
+            description.append(m_footer);
+    }
+
+private:
+    const QString m_toFormat;
+    const QString m_viaFormat;
+    const QString m_stationInfoFormat;
+    const QString m_lineFormat;
+    const QString m_footer;
+    const QString m_dateFormat;
+    const QString m_timeFormat;
+    bool m_compactFormat;
+
+    template <class Leg>
+    void appendLeg(QString &description, const Leg &leg) const
+    {
+        const QString train = leg.direction.isEmpty()
+                              ? leg.train
+                              : m_toFormat.arg(leg.train, leg.direction);
+
+        if (!m_compactFormat && !train.isEmpty())
+            description.append("--- ").append(train).append(" ---\n");
+
+        appendStation(description, leg.departureDateTime, leg.departureStation, leg.departureInfo);
+
+        if (m_compactFormat && !train.isEmpty())
+            description.append("--- ").append(train).append(" ---\n");
+
+        appendStation(description, leg.arrivalDateTime, leg.arrivalStation, leg.arrivalInfo);
+
+        if (!m_compactFormat) {
+            if (!leg.info.isEmpty())
+                description.append(leg.info).append('\n');
+            description.append('\n');
+        }
+    }
+
+    void appendStation(QString &out, const QDateTime &dateTime, const QString &stationName, const QString &info) const
+    {
+        out.append(m_lineFormat.arg(dateTime.toString(m_dateFormat),
+                                    dateTime.toString(m_timeFormat),
+                                    info.isEmpty() ? stationName : m_stationInfoFormat.arg(stationName, info)));
+        out.append('\n');
+    }
+};
+
 }
 
 CalendarThreadWrapper::CalendarThreadWrapper(JourneyDetailResultList *result, QObject *parent) :
-    QObject(parent), m_result(result)
+    QObject(parent)
 {
+    addJourney(result);
+}
+
+CalendarThreadWrapper::CalendarThreadWrapper(const QList<JourneyDetailResultList *> &results, const QString &fileName, QObject *parent) :
+    QObject(parent), m_fileName(fileName)
+{
+    foreach (JourneyDetailResultList *result, results)
+        addJourney(result);
 }
 
 CalendarThreadWrapper::~CalendarThreadWrapper()
@@ -68,59 +164,155 @@ CalendarThreadWrapper::~CalendarThreadWrapper()
 
 }
 
+void CalendarThreadWrapper::addJourney(JourneyDetailResultList *result)
+{
+    if (!result)
+        return;
+
+    Journey journey;
+    journey.departureStation = result->departureStation();
+    journey.viaStation = result->viaStation();
+    journey.arrivalStation = result->arrivalStation();
+    journey.info = result->info();
+    journey.departureDateTime = result->departureDateTime();
+    journey.arrivalDateTime = result->arrivalDateTime();
+
+    for (int i = 0; i < result->itemcount(); i++) {
+        JourneyDetailResultItem *item = result->getItem(i);
+
+        Leg leg;
+        leg.train = item->train();
+        leg.direction = item->direction();
+        leg.info = item->info();
+        leg.departureDateTime = item->departureDateTime();
+        leg.departureStation = item->departureStation();
+        leg.departureInfo = item->departureInfo();
+        leg.arrivalDateTime = item->arrivalDateTime();
+        leg.arrivalStation = item->arrivalStation();
+        leg.arrivalInfo = item->arrivalInfo();
+        journey.legs.append(leg);
+    }
+
+    m_journeys.append(journey);
+}
+
 void CalendarThreadWrapper::addToCalendar()
 {
+    const bool success = m_fileName.isEmpty() ? saveToCalendar() : writeICalendar(m_fileName);
+    emit addCalendarEntryComplete(success);
+
+    QThread::currentThread()->exit(0);
+
+    // Move back to GUI thread so the deleteLater() callback works (it requires
+    // an event loop which is still alive)
+    moveToThread(QCoreApplication::instance()->thread());
+}
+
+bool CalendarThreadWrapper::writeICalendar(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    const CalendarEntryFormatter formatter;
+    const QString timeStamp = QDateTime::currentDateTime().toUTC().toString(ICAL_DATE_TIME_FORMAT);
+
+    // Reused for every event.
+    QString description;
+    description.reserve(2048);
+    QString line;
+    line.reserve(2048);
+
+    stream << "BEGIN:VCALENDAR\r\n"
+           << "VERSION:2.0\r\n"
+           << "PRODID:-//Fahrplan//NONSGML Fahrplan//EN\r\n";
+
+    foreach (const Journey &journey, m_journeys) {
+        const QString title = formatter.title(journey);
+        const QString start = journey.departureDateTime.toUTC().toString(ICAL_DATE_TIME_FORMAT);
+        formatter.description(description, journey);
+
+        stream << "BEGIN:VEVENT\r\n";
+        writeICalendarProperty(stream, "UID", QString("%1-%2@fahrplan").arg(start).arg(qHash(title)), line);
+        stream << "DTSTAMP:" << timeStamp << "\r\n"
+               << "DTSTART:" << start << "\r\n"
+               << "DTEND:" << journey.arrivalDateTime.toUTC().toString(ICAL_DATE_TIME_FORMAT) << "\r\n";
+        writeICalendarProperty(stream, "SUMMARY", title, line);
+        writeICalendarProperty(stream, "DESCRIPTION", description, line);
+        stream << "END:VEVENT\r\n";
+    }
+
+    stream << "END:VCALENDAR\r\n";
+    stream.flush();
+
+    return stream.status() == QTextStream::Ok && file.error() == QFile::NoError;
+}
+
+void CalendarThreadWrapper::writeICalendarProperty(QTextStream &stream, const char *name, const QString &value, QString &line)
+{
+    line.resize(0);
+    line.append(QLatin1String(name)).append(':');
+    for (int i = 0; i < value.length(); ++i) {
+        const QChar c = value.at(i);
+        switch (c.unicode()) {
+        case '\\':
+            line.append(QLatin1String("\\\\"));
+            break;
+        case ';':
+            line.append(QLatin1String("\\;"));
+            break;
+        case ',':
+            line.append(QLatin1String("\\,"));
+            break;
+        case '\n':
+            line.append(QLatin1String("\\n"));
+            break;
+        case '\r':
+            break;
+        default:
+            line.append(c);
+        }
+    }
 
-    const QString viaStation = m_result->viaStation();
-    QSettings settings(FAHRPLAN_SETTINGS_NAMESPACE, "fahrplan2");
-    QString calendarEntryTitle;
-    QString calendarEntryDesc;
-
-    if (viaStation.isEmpty())
-        calendarEntryTitle = tr("%1 to %2").arg(m_result->departureStation(),
-                                                m_result->arrivalStation());
-    else
-        calendarEntryTitle = tr("%1 via %3 to %2").arg(m_result->departureStation(),
-                                                       m_result->arrivalStation(),
-                                                       viaStation);
-
-    if (!m_result->info().isEmpty())
-        calendarEntryDesc.append(m_result->info()).append("\n");
-
-    const bool compactFormat = settings.value("compactCalendarEntries", false).toBool();
-    for (int i=0; i < m_result->itemcount(); i++) {
-        JourneyDetailResultItem *item = m_result->getItem(i);
-
-        const QString train = item->direction().isEmpty()
-                              ? item->train()
-                              : tr("%1 to %2").arg(item->train(), item->direction());
-
-        if (!compactFormat && !train.isEmpty())
-            calendarEntryDesc.append("--- ").append(train).append(" ---\n");
-
-        calendarEntryDesc.append(formatStation(item->departureDateTime(),
-                                               item->departureStation(),
-                                               item->departureInfo()));
-        calendarEntryDesc.append("\n");
-
-        if (compactFormat && !train.isEmpty())
-            calendarEntryDesc.append("--- ").append(train).append(" ---\n");
-
-        calendarEntryDesc.append(formatStation(item->arrivalDateTime(),
-                                               item->arrivalStation(),
-                                               item->arrivalInfo()));
-        calendarEntryDesc.append("\n");
-
-        if (!compactFormat) {
-            if (!item->info().isEmpty())
-                calendarEntryDesc.append(item->info()).append("\n");
-            calendarEntryDesc.append("\n");
+    // Content lines are folded after 75 octets of UTF-8 (RFC 5545, 3.1),
+    // surrogate pairs count as one character and are never split.
+    int start = 0;
+    int octets = 0;
+    for (int i = 0; i < line.length(); ++i) {
+        const QChar c = line.at(i);
+        int size;
+        if (c.isLowSurrogate())
+            size = 0;
+        else if (c.isHighSurrogate())
+            size = 4;
+        else if (c.unicode() < 0x80)
+            size = 1;
+        else if (c.unicode() < 0x800)
+            size = 2;
+        else
+            size = 3;
+
+        if (octets + size > 75) {
+            stream << QString::fromRawData(line.constData() + start, i - start) << "\r\n ";
+            start = i;
+            // The folding space counts too.
+            octets = 1;
         }
+        octets += size;
     }
+    stream << QString::fromRawData(line.constData() + start, line.length() - start) << "\r\n";
+}
 
-    if (!compactFormat)
-        calendarEntryDesc.append(
-            tr("-- \nAdded by Fahrplan. Please, re-check the information before your journey."));
+bool CalendarThreadWrapper::saveToCalendar()
+{
+    if (m_journeys.isEmpty())
+        return true;
+
+    FahrplanSettings *settings = FahrplanSettings::instance();
+    const CalendarEntryFormatter formatter;
 
 #ifdef BUILD_FOR_BLACKBERRY
 
@@ -128,66 +320,106 @@ void CalendarThreadWrapper::addToCalendar()
 
     QPair<AccountId, FolderId> folder;
 
-    settings.beginGroup("Calendar");
-    folder.first = settings.value("AccountId", -1).toInt();
+    folder.first = settings->value("Calendar/AccountId", -1).toInt();
     if (folder.first >= 0)
-        folder.second = settings.value("FolderId", -1).toInt();
+        folder.second = settings->value("Calendar/FolderId", -1).toInt();
 
     if ((folder.first < 0) || (folder.second < 0))
         folder = service.defaultCalendarFolder();
 
-    CalendarEvent event;
-    event.setAccountId(folder.first);
-    event.setFolderId(folder.second);
-    event.setSubject(calendarEntryTitle);
-    event.setStartTime(m_result->departureDateTime());
-    event.setEndTime(m_result->arrivalDateTime());
-    event.setBody(calendarEntryDesc);
-    event.setReminder(-1);
+    // Reused for every event.
+    QString description;
+    description.reserve(2048);
+
+    bool success = true;
+    foreach (const Journey &journey, m_journeys) {
+        formatter.description(description, journey);
 
-    emit addCalendarEntryComplete(service.createEvent(event) == Result::Success);
+        CalendarEvent event;
+        event.setAccountId(folder.first);
+        event.setFolderId(folder.second);
+        event.setSubject(formatter.title(journey));
+        event.setStartTime(journey.departureDateTime);
+        event.setEndTime(journey.arrivalDateTime);
+        event.setBody(description);
+        event.setReminder(-1);
+
+        success &= service.createEvent(event) == Result::Success;
+    }
+    return success;
 
 #elif defined(BUILD_FOR_HARMATTAN) || defined(BUILD_FOR_MAEMO_5) || defined(BUILD_FOR_SYMBIAN)
 
-    QOrganizerManager defaultManager;
-    QOrganizerEvent event;
-    event.setDisplayLabel(calendarEntryTitle);
-    event.setStartDateTime(m_result->departureDateTime());
-    event.setEndDateTime(m_result->arrivalDateTime());
-    event.setDescription(calendarEntryDesc);
-
-    QString id = settings.value("Calendar/CollectionId").toString();
-    if (!id.isEmpty()) {
-        QOrganizerCollectionId collectionId = QOrganizerCollectionId::fromString(id);
+    QOrganizerCollectionId collectionId;
+    QString id = settings->value("Calendar/CollectionId").toString();
+    if (!id.isEmpty())
+        collectionId = QOrganizerCollectionId::fromString(id);
+
+    // Reused for every event.
+    QString description;
+    description.reserve(2048);
+
+    QList<QOrganizerItem> events;
+    foreach (const Journey &journey, m_journeys) {
+        formatter.description(description, journey);
+
+        QOrganizerEvent event;
+        event.setDisplayLabel(formatter.title(journey));
+        event.setStartDateTime(journey.departureDateTime);
+        event.setEndDateTime(journey.arrivalDateTime);
+        event.setDescription(description);
         if (!collectionId.isNull())
             event.setCollectionId(collectionId);
+        events.append(event);
     }
 
-    emit addCalendarEntryComplete(defaultManager.saveItem(&event));
-  #elif defined(BUILD_FOR_SAILFISHOS) && defined(BUILD_FOR_OPENREPOS)
+    // All events are saved in one go.
+    QOrganizerManager defaultManager;
+    return defaultManager.saveItems(&events);
+
+#elif defined(BUILD_FOR_SAILFISHOS) && defined(BUILD_FOR_OPENREPOS)
 
     mKCal::ExtendedCalendar::Ptr calendar = mKCal::ExtendedCalendar::Ptr ( new mKCal::ExtendedCalendar( QLatin1String( "UTC" ) ) );
     mKCal::ExtendedStorage::Ptr storage = mKCal::ExtendedCalendar::defaultStorage( calendar );
-    if (storage->open()) {
-        mKCal::Notebook::Ptr notebook = storage->defaultNotebook();
+    if (!storage->open())
+        return false;
+
+    // Reused for every event.
+    QString description;
+    description.reserve(2048);
+
+    mKCal::Notebook::Ptr notebook = storage->defaultNotebook();
+    foreach (const Journey &journey, m_journeys) {
+        formatter.description(description, journey);
+
         KCalCore::Event::Ptr event = KCalCore::Event::Ptr( new KCalCore::Event() );
-        event->setSummary(calendarEntryTitle);
-        event->setDescription(calendarEntryDesc);
-        event->setDtStart( KDateTime(m_result->departureDateTime()) );
-        event->setDtEnd( KDateTime(m_result->arrivalDateTime()) );
+        event->setSummary(formatter.title(journey));
+        event->setDescription(description);
+        event->setDtStart( KDateTime(journey.departureDateTime) );
+        event->setDtEnd( KDateTime(journey.arrivalDateTime) );
         calendar->addEvent( event, notebook->uid() );
-        storage->save();
-        emit addCalendarEntryComplete(true);
-    } else {
-        emit addCalendarEntryComplete(false);
     }
-#else
-    emit addCalendarEntryComplete(false);
-#endif
+    // Stored with a single write.
+    return storage->save();
 
-    QThread::currentThread()->exit(0);
+#else
+    // No calendar backend, the journeys go to an iCalendar file in the
+    // documents folder instead, which calendar applications can import.
+    Q_UNUSED(settings);
+    Q_UNUSED(formatter);
 
-    // Move back to GUI thread so the deleteLater() callback works (it requires
-    // an event loop which is still alive)
-    moveToThread(QCoreApplication::instance()->thread());
+#if defined(BUILD_FOR_QT5)
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+#else
+    QString dir = QDesktopServices::storageLocation(QDesktopServices::DocumentsLocation);
+#endif
+    if (dir.isEmpty())
+        dir = QDir::homePath();
+    QDir().mkpath(dir);
+
+    const QDateTime departure = m_journeys.first().departureDateTime;
+    const QString fileName = QString("%1/Fahrplan %2.ics").arg(dir, departure.toString("yyyy-MM-dd HHmm"));
+    qDebug() << "No calendar backend, writing" << fileName;
+    return writeICalendar(fileName);
+#endif
 }
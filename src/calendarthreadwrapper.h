@@ -17,24 +17,63 @@
 **
 ****************************************************************************/
 
+
 #ifndef CALENDARTHREADWRAPPER_H
 #define CALENDARTHREADWRAPPER_H
 
+#include <QDateTime>
 #include <QObject>
 #include "parser/parser_definitions.h"
 
+class QTextStream;
+
 class CalendarThreadWrapper : public QObject
 {
     Q_OBJECT
     public:
+        // Adds the journey to the selected calendar.
         explicit CalendarThreadWrapper(JourneyDetailResultList *result, QObject *parent = 0);
+        // Adds all journeys in one batch. They are written to an iCalendar
+        // file if fileName is set, else to the selected calendar.
+        CalendarThreadWrapper(const QList<JourneyDetailResultList *> &results, const QString &fileName, QObject *parent = 0);
         virtual ~CalendarThreadWrapper();
     public slots:
         void addToCalendar();
     signals:
         void addCalendarEntryComplete(bool success);
     private:
-        JourneyDetailResultList * const m_result;
+        // Copies of the results, taken in the constructor on the thread
+        // owning them, so the worker never touches the result objects.
+        struct Leg
+        {
+            QString train;
+            QString direction;
+            QString info;
+            QDateTime departureDateTime;
+            QString departureStation;
+            QString departureInfo;
+            QDateTime arrivalDateTime;
+            QString arrivalStation;
+            QString arrivalInfo;
+        };
+        struct Journey
+        {
+            QString departureStation;
+            QString viaStation;
+            QString arrivalStation;
+            QString info;
+            QDateTime departureDateTime;
+            QDateTime arrivalDateTime;
+            QList<Leg> legs;
+        };
+
+        QList<Journey> m_journeys;
+        const QString m_fileName;
+
+        void addJourney(JourneyDetailResultList *result);
+        bool writeICalendar(const QString &fileName);
+        bool saveToCalendar();
+        static void writeICalendarProperty(QTextStream &stream, const char *name, const QString &value, QString &line);
 };
 
 #endif // CALENDARTHREADWRAPPER_H
@@ -0,0 +1,161 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "cli_json.h"
+#include "parser/parser_registry.h"
+
+QString CliJson::string(const QString &value)
+{
+    QString result;
+    result.reserve(value.length() + 2);
+    result += '"';
+    for (int i = 0; i < value.length(); ++i) {
+        const QChar c = value.at(i);
+        switch (c.unicode()) {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\r':
+            result += "\\r";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        default:
+            if (c.unicode() < 0x20)
+                result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+            else
+                result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+QString CliJson::dateTime(const QDateTime &value)
+{
+    return value.isValid() ? string(value.toString(Qt::ISODate)) : QString("null");
+}
+
+QString CliJson::boolean(bool value)
+{
+    return value ? "true" : "false";
+}
+
+QString CliJson::stringList(const QStringList &list)
+{
+    QStringList items;
+    foreach (const QString &value, list)
+        items << string(value);
+    return "[" + items.join(",") + "]";
+}
+
+QString CliJson::station(const Station &value)
+{
+    if (!value.valid)
+        return "null";
+
+    return QString("{\"id\":%1,\"name\":%2,\"type\":%3,\"miscInfo\":%4,\"latitude\":%5,\"longitude\":%6}")
+            .arg(string(value.id.toString()), string(value.name), string(value.type), string(value.miscInfo),
+                 QString::number(value.latitude, 'g', 10), QString::number(value.longitude, 'g', 10));
+}
+
+QString CliJson::stations(const StationsList &list)
+{
+    QStringList items;
+    foreach (const Station &value, list)
+        items << station(value);
+    return "[" + items.join(",") + "]";
+}
+
+QString CliJson::timetable(const Station &current, const Station &direction, const TimetableEntriesList &entries)
+{
+    QStringList items;
+    foreach (const TimetableEntry &entry, entries) {
+        items << QString("{\"time\":%1,\"station\":%2,\"destination\":%3,\"trainType\":%4,\"platform\":%5,\"miscInfo\":%6}")
+                 .arg(string(entry.time.toString("HH:mm")), string(entry.currentStation), string(entry.destinationStation),
+                      string(entry.trainType), string(entry.platform), string(entry.miscInfo));
+    }
+    return QString("{\"station\":%1,\"direction\":%2,\"entries\":[%3]}")
+            .arg(station(current), station(direction), items.join(","));
+}
+
+QString CliJson::journey(JourneyResultList *list, int row, const QString &idPrefix)
+{
+    // Values are only substituted in one go, a later arg() would pick
+    // up placeholders inside of them.
+    return QString("{\"id\":%1,\"date\":%2,\"departureTime\":%3,\"arrivalTime\":%4,\"departure\":%5,\"arrival\":%6,"
+                   "\"duration\":%7,\"transfers\":%8,\"trainType\":%9,")
+            .arg(string(idPrefix + list->id(row)), string(list->date(row).toString(Qt::ISODate)),
+                 string(list->departureTime(row)), string(list->arrivalTime(row)),
+                 dateTime(list->departureDateTime(row)), dateTime(list->arrivalDateTime(row)),
+                 string(list->duration(row)), string(list->transfers(row)), string(list->trainType(row)))
+            + "\"miscInfo\":" + string(list->miscInfo(row)) + "}";
+}
+
+QString CliJson::journeyList(JourneyResultList *list, const QString &idPrefix)
+{
+    QStringList items;
+    const int count = list->itemcount();
+    for (int i = 0; i < count; ++i)
+        items << journey(list, list->row(i), idPrefix);
+    return QString("{\"departureStation\":%1,\"viaStation\":%2,\"arrivalStation\":%3,\"timeInfo\":%4,\"journeys\":[%5]}")
+            .arg(string(list->departureStation()), string(list->viaStation()), string(list->arrivalStation()),
+                 string(list->timeInfo()), items.join(","));
+}
+
+QString CliJson::journeyDetails(JourneyDetailResultList *details)
+{
+    QStringList legs;
+    const int count = details->itemcount();
+    for (int i = 0; i < count; ++i) {
+        JourneyDetailResultItem *leg = details->getItem(i);
+        legs << QString("{\"departureStation\":%1,\"departureInfo\":%2,\"departure\":%3,\"arrivalStation\":%4,"
+                        "\"arrivalInfo\":%5,\"arrival\":%6,\"train\":%7,\"direction\":%8,\"info\":%9}")
+                .arg(string(leg->departureStation()), string(leg->departureInfo()), dateTime(leg->departureDateTime()),
+                     string(leg->arrivalStation()), string(leg->arrivalInfo()), dateTime(leg->arrivalDateTime()),
+                     string(leg->train()), string(leg->direction()), string(leg->info()));
+    }
+    return QString("{\"id\":%1,\"departureStation\":%2,\"departure\":%3,\"viaStation\":%4,\"arrivalStation\":%5,"
+                   "\"arrival\":%6,\"duration\":%7,\"info\":%8,\"legs\":[%9]}")
+            .arg(string(details->id()), string(details->departureStation()), dateTime(details->departureDateTime()),
+                 string(details->viaStation()), string(details->arrivalStation()), dateTime(details->arrivalDateTime()),
+                 string(details->duration()), string(details->info()), legs.join(","));
+}
+
+QString CliJson::backendList()
+{
+    QStringList items;
+    for (int i = 0; i < ParserRegistry::count(); ++i) {
+        const ParserInfo &info = ParserRegistry::info(i);
+        items << QString("{\"index\":%1,\"uid\":%2,\"name\":%3,\"shortName\":%4,\"gps\":%5,\"via\":%6,"
+                         "\"board\":%7,\"boardDirection\":%8,\"trainRestrictions\":%9}")
+                 .arg(QString::number(i), string(QLatin1String(info.uid)), string(info.name()), string(info.shortName()),
+                      boolean(info.supportsGps()), boolean(info.supportsVia()), boolean(info.supportsTimeTable()),
+                      boolean(info.supportsTimeTableDirection()), stringList(info.trainRestrictions()));
+    }
+    return "[" + items.join(",") + "]";
+}
@@ -0,0 +1,49 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef CLI_JSON_H
+#define CLI_JSON_H
+
+#include "parser/parser_definitions.h"
+
+/**
+ * @brief JSON output of fahrplan-cli.
+ * Qt 4 has no JSON support, the few shapes needed are written by hand.
+ * Every function returns a complete JSON value.
+ */
+namespace CliJson
+{
+    QString string(const QString &value);
+    // ISO 8601, null if invalid
+    QString dateTime(const QDateTime &value);
+    QString boolean(bool value);
+    QString stringList(const QStringList &list);
+
+    QString station(const Station &value);
+    QString stations(const StationsList &list);
+    QString timetable(const Station &current, const Station &direction, const TimetableEntriesList &entries);
+    // idPrefix is put in front of the journey ids
+    QString journey(JourneyResultList *list, int row, const QString &idPrefix = QString());
+    QString journeyList(JourneyResultList *list, const QString &idPrefix = QString());
+    QString journeyDetails(JourneyDetailResultList *details);
+    QString backendList();
+}
+
+#endif // CLI_JSON_H
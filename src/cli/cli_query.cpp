@@ -0,0 +1,197 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "cli_query.h"
+#include "parser/parser_registry.h"
+
+CliQuery::CliQuery()
+    : command(None)
+    , latitude(0)
+    , longitude(0)
+    , backend(0)
+    , mode(ParserAbstract::Departure)
+    , trainrestrictions(0)
+{
+}
+
+bool CliQuery::parse(const QStringList &tokens, QString *error)
+{
+    QStringList positional;
+
+    for (int i = 0; i < tokens.count(); ++i) {
+        const QString &token = tokens.at(i);
+
+        if (token == "-a" || token == "--arrival") {
+            mode = ParserAbstract::Arrival;
+            continue;
+        }
+        if (token == "-d" || token == "--departure") {
+            mode = ParserAbstract::Departure;
+            continue;
+        }
+        if (token == "-b" || token == "--backend" || token == "-t" || token == "--time"
+                || token == "-r" || token == "--restriction") {
+            if (i + 1 >= tokens.count()) {
+                *error = QString("Missing value for %1").arg(token);
+                return false;
+            }
+            const QString value = tokens.at(++i);
+
+            if (token == "-b" || token == "--backend") {
+                backend = backendIndex(value);
+                if (backend < 0) {
+                    *error = QString("Unknown backend %1").arg(value);
+                    return false;
+                }
+            } else if (token == "-t" || token == "--time") {
+                dateTime = value == "now" ? QDateTime() : QDateTime::fromString(value, Qt::ISODate);
+                if (value != "now" && !dateTime.isValid()) {
+                    *error = QString("Invalid time %1, expected yyyy-MM-ddTHH:mm").arg(value);
+                    return false;
+                }
+            } else {
+                bool ok;
+                trainrestrictions = value.toInt(&ok);
+                if (!ok || trainrestrictions < 0) {
+                    *error = QString("Invalid train restriction %1").arg(value);
+                    return false;
+                }
+            }
+            continue;
+        }
+        if (token.startsWith("--")) {
+            *error = QString("Unknown option %1").arg(token);
+            return false;
+        }
+        positional << token;
+    }
+
+    if (positional.isEmpty())
+        return true;
+
+    const QString name = positional.takeFirst();
+    int minArgs = 1;
+    int maxArgs = 1;
+    if (name == "stations") {
+        command = Stations;
+    } else if (name == "nearby") {
+        command = Nearby;
+        minArgs = maxArgs = 2;
+    } else if (name == "board") {
+        command = Board;
+        maxArgs = 2;
+    } else if (name == "journey" || name == "details") {
+        command = name == "journey" ? Journey : Details;
+        minArgs = 2;
+        maxArgs = 3;
+    } else {
+        *error = QString("Unknown command %1").arg(name);
+        return false;
+    }
+
+    if (positional.count() < minArgs || positional.count() > maxArgs) {
+        *error = QString("Wrong number of arguments for %1").arg(name);
+        return false;
+    }
+
+    if (command == Nearby) {
+        bool latOk, lonOk;
+        latitude = positional.at(0).toDouble(&latOk);
+        longitude = positional.at(1).toDouble(&lonOk);
+        if (!latOk || !lonOk) {
+            *error = QString("Invalid coordinates %1 %2").arg(positional.at(0), positional.at(1));
+            return false;
+        }
+    } else {
+        stations = positional;
+    }
+
+    return true;
+}
+
+QString CliQuery::commandName(Command command)
+{
+    switch (command) {
+    case Stations:
+        return "stations";
+    case Nearby:
+        return "nearby";
+    case Board:
+        return "board";
+    case Journey:
+        return "journey";
+    case Details:
+    case JourneyDetails:
+        return "details";
+    default:
+        return QString();
+    }
+}
+
+QStringList CliQuery::split(const QString &line)
+{
+    QStringList tokens;
+    QString token;
+    bool inToken = false;
+    bool quoted = false;
+
+    for (int i = 0; i < line.length(); ++i) {
+        const QChar c = line.at(i);
+        if (c == '\\' && i + 1 < line.length()) {
+            token += line.at(++i);
+            inToken = true;
+        } else if (c == '"') {
+            quoted = !quoted;
+            inToken = true;
+        } else if (c.isSpace() && !quoted) {
+            if (inToken)
+                tokens << token;
+            token.clear();
+            inToken = false;
+        } else {
+            token += c;
+            inToken = true;
+        }
+    }
+    if (inToken)
+        tokens << token;
+
+    return tokens;
+}
+
+int CliQuery::backendIndex(const QString &backend)
+{
+    bool ok;
+    const int index = backend.toInt(&ok);
+    if (ok)
+        return index >= 0 && index < ParserRegistry::count() ? index : -1;
+
+    const int uidIndex = ParserRegistry::indexOf(backend);
+    if (uidIndex >= 0)
+        return uidIndex;
+
+    for (int i = 0; i < ParserRegistry::count(); ++i) {
+        const ParserInfo &info = ParserRegistry::info(i);
+        if (backend.compare(info.shortName(), Qt::CaseInsensitive) == 0
+                || backend.compare(info.name(), Qt::CaseInsensitive) == 0)
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef CLI_QUERY_H
+#define CLI_QUERY_H
+
+#include "parser/parser_abstract.h"
+
+#include <QStringList>
+
+/**
+ * @brief One lookup of fahrplan-cli.
+ * Queries are written like shell commands, e.g.
+ * "journey Berlin München --time 2015-06-01T08:00". Options given on the
+ * command line are the defaults for all queries read from a file.
+ */
+struct CliQuery
+{
+    enum Command {
+        None,
+        Stations,
+        Nearby,
+        Board,
+        Journey,
+        Details,
+        // Details of a journey id returned by an earlier journey search,
+        // only available to fahrplan-cli --serve.
+        JourneyDetails
+    };
+
+    CliQuery();
+
+    // Applies the options in tokens and takes the remaining ones as the
+    // command. Leaves command at None if there are no positional tokens.
+    bool parse(const QStringList &tokens, QString *error);
+
+    static QString commandName(Command command);
+    // Splits at whitespace, double quotes group words and \ escapes.
+    static QStringList split(const QString &line);
+    // Accepts an index, a backend uid or a (short) name.
+    static int backendIndex(const QString &backend);
+
+    Command command;
+    QStringList stations;
+    QString journeyId;
+    qreal latitude;
+    qreal longitude;
+    int backend;
+    // Invalid means now, at the time the query is run.
+    QDateTime dateTime;
+    ParserAbstract::Mode mode;
+    int trainrestrictions;
+};
+
+#endif // CLI_QUERY_H
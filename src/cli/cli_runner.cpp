@@ -0,0 +1,434 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "cli_runner.h"
+#include "cli_json.h"
+#include "fahrplan_parser_thread.h"
+
+#include <QTextStream>
+
+CliWorker::CliWorker(QHash<QString, Station> *stationCache, int timeout, QObject *parent)
+    : QObject(parent)
+    , m_thread(NULL)
+    , m_backend(-1)
+    , m_stationCache(stationCache)
+    , m_journeySearches(0)
+    , m_timeout(timeout)
+    , m_index(-1)
+    , m_step(Idle)
+    , m_reply(NULL)
+{
+}
+
+CliWorker::~CliWorker()
+{
+    // Replies still queued are dropped with the worker.
+    delete m_reply;
+    qDeleteAll(m_lookups);
+
+    QList<FahrplanParserThread *> threads = m_searches.values();
+    if (m_thread && !threads.contains(m_thread))
+        threads << m_thread;
+
+    foreach (FahrplanParserThread *thread, threads) {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+int CliWorker::backend() const
+{
+    return m_backend;
+}
+
+bool CliWorker::isBusy() const
+{
+    return m_step != Idle;
+}
+
+void CliWorker::setName(const QString &name)
+{
+    m_name = name;
+}
+
+void CliWorker::run(int index, const CliQuery &query)
+{
+    m_index = index;
+    m_query = query;
+    m_dateTime = query.dateTime.isValid() ? query.dateTime : QDateTime::currentDateTime();
+    m_resolved.clear();
+    m_stepTimes.clear();
+    m_journey.clear();
+    m_elapsed.start();
+
+    setBackend(query.backend);
+
+    switch (query.command) {
+    case CliQuery::Stations:
+        request(FindStations, m_thread->queryStationsByName(query.stations.first()));
+        break;
+    case CliQuery::Nearby:
+        if (!m_thread->supportsGps()) {
+            fail("The backend does not support searching by coordinates", Unsupported);
+            return;
+        }
+        request(FindNearby, m_thread->queryStationsByCoordinates(query.longitude, query.latitude));
+        break;
+    case CliQuery::Board:
+        if (!m_thread->supportsTimeTable()) {
+            fail("The backend does not support station boards", Unsupported);
+            return;
+        }
+        if (query.stations.count() > 1 && !m_thread->supportsTimeTableDirection()) {
+            fail("The backend does not support a direction for station boards", Unsupported);
+            return;
+        }
+        resolveStations();
+        break;
+    case CliQuery::JourneyDetails: {
+        QString journey;
+        FahrplanParserThread *thread = journeyThread(query.journeyId, &journey);
+        if (!thread) {
+            fail("The journey expired, search it again", Expired);
+            return;
+        }
+        if (!m_searches.values().contains(m_thread))
+            retireThread(m_thread);
+        m_thread = thread;
+        request(GetJourneyDetails, m_thread->queryJourneyDetails(journey));
+        break;
+    }
+    default:
+        if (query.stations.count() > 2 && !m_thread->supportsVia()) {
+            fail("The backend does not support via stations", Unsupported);
+            return;
+        }
+        resolveStations();
+        break;
+    }
+}
+
+void CliWorker::onReplyFinished()
+{
+    FahrplanParserReply *reply = qobject_cast<FahrplanParserReply *>(sender());
+    if (!reply || reply != m_reply)
+        return;
+
+    // Result lists are owned by the parser, the reply is no longer needed.
+    m_reply = NULL;
+    reply->deleteLater();
+    finishStep();
+
+    if (reply->hasError()) {
+        qDeleteAll(m_lookups);
+        m_lookups.clear();
+        fail(reply->errorString());
+        return;
+    }
+
+    switch (m_step) {
+    case FindStations:
+    case FindNearby:
+        succeed(CliJson::stations(reply->stations()));
+        break;
+    case ResolveStation: {
+        const QMap<QString, FahrplanParserReply *> lookups = m_lookups;
+        m_lookups.clear();
+        QString missing;
+        for (QMap<QString, FahrplanParserReply *>::const_iterator it = lookups.constBegin(); it != lookups.constEnd(); ++it) {
+            const StationsList stations = it.value()->stations();
+            if (stations.isEmpty()) {
+                if (missing.isEmpty())
+                    missing = it.key();
+                continue;
+            }
+            m_stationCache->insert(QString("%1\n%2").arg(m_backend).arg(it.key()), stations.first());
+        }
+        qDeleteAll(lookups);
+
+        if (!missing.isEmpty()) {
+            fail(QString("No station found for %1").arg(missing), NotFound);
+            return;
+        }
+        resolveStations();
+        break;
+    }
+    case GetTimeTable:
+        succeed(CliJson::timetable(m_resolved.first(), m_resolved.value(1, Station(false)), reply->timeTable()));
+        break;
+    case SearchJourney: {
+        JourneyResultList *result = reply->journeyResult();
+        if (m_query.command == CliQuery::Journey) {
+            succeed(CliJson::journeyList(result, journeyIdPrefix()));
+            return;
+        }
+
+        if (!result || result->itemcount() < 1) {
+            fail("No journeys found", NotFound);
+            return;
+        }
+
+        // The result list may be gone once the details arrive, so the
+        // journey is written out right away.
+        const int row = result->row(0);
+        m_journey = CliJson::journey(result, row, journeyIdPrefix());
+        request(GetJourneyDetails, m_thread->queryJourneyDetails(result->id(row)));
+        break;
+    }
+    case GetJourneyDetails:
+        if (m_query.command == CliQuery::JourneyDetails)
+            succeed(CliJson::journeyDetails(reply->journeyDetailsResult()));
+        else
+            succeed(QString("{\"journey\":%1,\"details\":%2}").arg(m_journey, CliJson::journeyDetails(reply->journeyDetailsResult())));
+        break;
+    default:
+        break;
+    }
+}
+
+FahrplanParserThread *CliWorker::newThread()
+{
+    FahrplanParserThread *thread = new FahrplanParserThread();
+    thread->init(m_backend);
+    thread->setQueryTimeout(m_timeout);
+    m_backendName = thread->shortName();
+    return thread;
+}
+
+void CliWorker::retireThread(FahrplanParserThread *thread)
+{
+    if (!thread)
+        return;
+
+    // Parser threads delete themselves after they quit. The journeys the
+    // thread found are gone with it.
+    thread->quit();
+    m_searches.remove(m_searches.key(thread));
+    if (m_thread == thread)
+        m_thread = NULL;
+}
+
+void CliWorker::setBackend(int backend)
+{
+    if (m_backend != backend) {
+        foreach (FahrplanParserThread *thread, m_searches.values())
+            retireThread(thread);
+        retireThread(m_thread);
+        m_backend = backend;
+    }
+
+    if (!m_thread)
+        m_thread = newThread();
+}
+
+void CliWorker::startSearch()
+{
+    // Each kept search has a thread of its own, the thread of the oldest
+    // one is taken over once all are in use.
+    const int kept = m_name.isEmpty() ? 1 : KeptSearches;
+    if (m_searches.values().contains(m_thread)) {
+        if (m_searches.count() < kept)
+            m_thread = newThread();
+        else
+            m_thread = m_searches.take(m_searches.constBegin().key());
+    }
+    m_searches.insert(++m_journeySearches, m_thread);
+}
+
+FahrplanParserThread *CliWorker::journeyThread(const QString &id, QString *journey) const
+{
+    if (m_name.isEmpty()) {
+        *journey = id;
+        return m_thread;
+    }
+
+    const QString prefix = m_name + '.';
+    const int colon = id.indexOf(':');
+    if (colon < 0 || !id.startsWith(prefix))
+        return NULL;
+
+    *journey = id.mid(colon + 1);
+    return m_searches.value(id.mid(prefix.length(), colon - prefix.length()).toInt());
+}
+
+QString CliWorker::journeyIdPrefix() const
+{
+    if (m_name.isEmpty())
+        return QString();
+    return QString("%1.%2:").arg(m_name).arg(m_journeySearches);
+}
+
+bool CliWorker::isJourneyKept(const QString &id) const
+{
+    QString journey;
+    return journeyThread(id, &journey) != NULL;
+}
+
+void CliWorker::request(Step step, FahrplanParserReply *reply)
+{
+    m_step = step;
+    m_reply = reply;
+    connect(reply, SIGNAL(finished()), SLOT(onReplyFinished()));
+    m_stepElapsed.start();
+}
+
+void CliWorker::resolveStations()
+{
+    // All names missing in the cache are looked up in one go.
+    foreach (const QString &name, m_query.stations) {
+        if (!m_stationCache->contains(QString("%1\n%2").arg(m_backend).arg(name)) && !m_lookups.contains(name))
+            m_lookups.insert(name, m_thread->queryStationsByName(name));
+    }
+    if (!m_lookups.isEmpty()) {
+        request(ResolveStation, FahrplanParserReply::all(m_lookups.values()));
+        return;
+    }
+
+    foreach (const QString &name, m_query.stations)
+        m_resolved << m_stationCache->value(QString("%1\n%2").arg(m_backend).arg(name));
+    requestResult();
+}
+
+void CliWorker::requestResult()
+{
+    if (m_query.command == CliQuery::Board) {
+        request(GetTimeTable, m_thread->queryTimeTableForStation(m_resolved.first(), m_resolved.value(1, Station(false)), m_dateTime,
+                                                                 m_query.mode, m_query.trainrestrictions));
+        return;
+    }
+
+    // Stations are given as departure, arrival and optionally via.
+    startSearch();
+    request(SearchJourney, m_thread->queryJourney(m_resolved.at(0), m_resolved.value(2, Station(false)), m_resolved.at(1), m_dateTime,
+                                                  m_query.mode, m_query.trainrestrictions));
+}
+
+void CliWorker::finishStep()
+{
+    static const char *const names[] = { "", "stations", "nearby", "stations", "board", "journey", "details" };
+
+    m_stepTimes << QString("{\"request\":\"%1\",\"ms\":%2}").arg(names[m_step]).arg(m_stepElapsed.elapsed());
+}
+
+void CliWorker::succeed(const QString &result)
+{
+    report("\"result\":" + result, NoError);
+}
+
+void CliWorker::fail(const QString &error, Error kind)
+{
+    report("\"error\":" + CliJson::string(error), kind);
+}
+
+void CliWorker::report(const QString &fields, Error error)
+{
+    m_step = Idle;
+
+    QStringList arguments = m_query.stations;
+    if (m_query.command == CliQuery::Nearby)
+        arguments << QString::number(m_query.latitude, 'g', 10) << QString::number(m_query.longitude, 'g', 10);
+    else if (m_query.command == CliQuery::JourneyDetails)
+        arguments << m_query.journeyId;
+
+    const QString json = QString("{\"query\":%1,\"command\":%2,\"arguments\":%3,\"backend\":%4,\"time\":%5,\"ok\":%6,"
+                                 "\"elapsedMs\":%7,\"requests\":[%8],%9}")
+            .arg(QString::number(m_index), CliJson::string(CliQuery::commandName(m_query.command)), CliJson::stringList(arguments),
+                 CliJson::string(m_backendName), CliJson::dateTime(m_dateTime), CliJson::boolean(error == NoError),
+                 QString::number(m_elapsed.elapsed()), m_stepTimes.join(","), fields);
+
+    emit done(m_index, json, error);
+}
+
+CliRunner::CliRunner(QTextStream *out, QObject *parent)
+    : QObject(parent)
+    , m_out(out)
+    , m_concurrency(1)
+    , m_timeout(30000)
+    , m_nextQuery(0)
+    , m_nextOutput(0)
+    , m_failed(false)
+{
+}
+
+void CliRunner::setConcurrency(int concurrency)
+{
+    m_concurrency = qMax(1, concurrency);
+}
+
+void CliRunner::setTimeout(int msecs)
+{
+    m_timeout = msecs;
+}
+
+void CliRunner::addQuery(const CliQuery &query)
+{
+    m_queries.append(query);
+}
+
+int CliRunner::exitCode() const
+{
+    return m_failed ? 1 : 0;
+}
+
+void CliRunner::start()
+{
+    const int count = qMin(m_concurrency, m_queries.count());
+    for (int i = 0; i < count; ++i) {
+        CliWorker *worker = new CliWorker(&m_stationCache, m_timeout, this);
+        // Queries failing right away would otherwise dispatch recursively.
+        connect(worker, SIGNAL(done(int,QString,int)), SLOT(onWorkerDone(int,QString,int)), Qt::QueuedConnection);
+        m_workers.append(worker);
+    }
+
+    foreach (CliWorker *worker, m_workers)
+        dispatch(worker);
+
+    if (m_queries.isEmpty())
+        emit finished();
+}
+
+void CliRunner::onWorkerDone(int index, const QString &json, int error)
+{
+    if (error != CliWorker::NoError)
+        m_failed = true;
+
+    m_pendingOutput.insert(index, json);
+    while (m_pendingOutput.contains(m_nextOutput))
+        *m_out << m_pendingOutput.take(m_nextOutput++) << '\n';
+    m_out->flush();
+
+    if (m_nextOutput == m_queries.count()) {
+        emit finished();
+        return;
+    }
+
+    CliWorker *worker = qobject_cast<CliWorker *>(sender());
+    if (worker)
+        dispatch(worker);
+}
+
+void CliRunner::dispatch(CliWorker *worker)
+{
+    if (m_nextQuery >= m_queries.count())
+        return;
+
+    const int index = m_nextQuery++;
+    worker->run(index, m_queries.at(index));
+}
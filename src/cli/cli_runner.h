@@ -0,0 +1,167 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef CLI_RUNNER_H
+#define CLI_RUNNER_H
+
+#include "cli_query.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+
+class FahrplanParserReply;
+class FahrplanParserThread;
+class QTextStream;
+
+/**
+ * @brief Runs one query after the other on parser threads of its own.
+ * Station names are resolved to the first match of the backend before the
+ * board or journey is requested, each request is a query with its own
+ * reply. The finished query is reported as a single line of JSON,
+ * including the time each request took.
+ */
+class CliWorker : public QObject
+{
+    Q_OBJECT
+
+    public:
+        // Why a query failed, sent along with done()
+        enum Error {
+            NoError,
+            Unsupported,
+            NotFound,
+            Expired,
+            BackendError
+        };
+
+        CliWorker(QHash<QString, Station> *stationCache, int timeout, QObject *parent = 0);
+        ~CliWorker();
+
+        int backend() const;
+        bool isBusy() const;
+        // Named workers put their name and the number of the search in
+        // front of journey ids, JourneyDetails queries accept ids of their
+        // last KeptSearches searches.
+        void setName(const QString &name);
+        void run(int index, const CliQuery &query);
+        // Prefix of the ids of the last journey search
+        QString journeyIdPrefix() const;
+        bool isJourneyKept(const QString &id) const;
+
+        static const int KeptSearches = 3;
+
+    signals:
+        void done(int index, const QString &json, int error);
+
+    private slots:
+        void onReplyFinished();
+
+    private:
+        enum Step {
+            Idle,
+            FindStations,
+            FindNearby,
+            ResolveStation,
+            GetTimeTable,
+            SearchJourney,
+            GetJourneyDetails
+        };
+
+        FahrplanParserThread *m_thread;
+        // Thread of each kept search, by its number
+        QMap<int, FahrplanParserThread *> m_searches;
+        int m_backend;
+        QString m_backendName;
+        QHash<QString, Station> *m_stationCache;
+        QString m_name;
+        int m_journeySearches;
+        int m_timeout;
+        QElapsedTimer m_elapsed;
+        QElapsedTimer m_stepElapsed;
+
+        int m_index;
+        CliQuery m_query;
+        QDateTime m_dateTime;
+        Step m_step;
+        FahrplanParserReply *m_reply;
+        // Station lookups of the names not cached yet, by name
+        QMap<QString, FahrplanParserReply *> m_lookups;
+        QList<Station> m_resolved;
+        QStringList m_stepTimes;
+        QString m_journey;
+
+        FahrplanParserThread *newThread();
+        void retireThread(FahrplanParserThread *thread);
+        void setBackend(int backend);
+        void startSearch();
+        FahrplanParserThread *journeyThread(const QString &id, QString *journey) const;
+        void request(Step step, FahrplanParserReply *reply);
+        void resolveStations();
+        void requestResult();
+        void finishStep();
+        void succeed(const QString &result);
+        void fail(const QString &error, Error kind = BackendError);
+        void report(const QString &fields, Error error);
+};
+
+/**
+ * @brief Distributes queries over a number of workers.
+ * Results are written to the stream in the order the queries were added,
+ * each as soon as it and all queries before it are finished.
+ */
+class CliRunner : public QObject
+{
+    Q_OBJECT
+
+    public:
+        CliRunner(QTextStream *out, QObject *parent = 0);
+
+        void setConcurrency(int concurrency);
+        void setTimeout(int msecs);
+        void addQuery(const CliQuery &query);
+        // 1 if any query failed
+        int exitCode() const;
+
+    public slots:
+        void start();
+
+    signals:
+        void finished();
+
+    private slots:
+        void onWorkerDone(int index, const QString &json, int error);
+
+    private:
+        QTextStream *m_out;
+        int m_concurrency;
+        int m_timeout;
+        QList<CliQuery> m_queries;
+        int m_nextQuery;
+        int m_nextOutput;
+        QMap<int, QString> m_pendingOutput;
+        QList<CliWorker *> m_workers;
+        QHash<QString, Station> m_stationCache;
+        bool m_failed;
+
+        void dispatch(CliWorker *worker);
+};
+
+#endif // CLI_RUNNER_H
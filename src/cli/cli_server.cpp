@@ -0,0 +1,376 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "cli_server.h"
+#include "cli_json.h"
+#include "cli_runner.h"
+
+#include <QTcpSocket>
+#include <QUrl>
+
+CliServer::CliServer(int poolSize, int timeout, QObject *parent)
+    : QObject(parent)
+    , m_poolSize(qMax(1, poolSize))
+    , m_timeout(timeout)
+    , m_cache(16 * 1024 * 1024)
+    , m_nextIndex(0)
+    , m_dispatching(false)
+    , m_dispatchAgain(false)
+{
+    m_clock.start();
+    connect(&m_server, SIGNAL(newConnection()), SLOT(onNewConnection()));
+}
+
+bool CliServer::listen(const QHostAddress &address, quint16 port)
+{
+    return m_server.listen(address, port);
+}
+
+QString CliServer::errorString() const
+{
+    return m_server.errorString();
+}
+
+void CliServer::onNewConnection()
+{
+    while (m_server.hasPendingConnections()) {
+        QTcpSocket *socket = m_server.nextPendingConnection();
+        connect(socket, SIGNAL(readyRead()), SLOT(onReadyRead()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void CliServer::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket)
+        return;
+
+    // Only the request line is used, but the whole header has to be there.
+    const QByteArray data = socket->peek(socket->bytesAvailable());
+    if (!data.contains("\r\n\r\n") && !data.contains("\n\n")) {
+        if (data.size() > 8192) {
+            disconnect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+            respond(socket, 400, errorBody("Request header too large"));
+        }
+        return;
+    }
+
+    // One request per connection, responses close it.
+    disconnect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+
+    const QList<QByteArray> requestLine = socket->readLine().trimmed().split(' ');
+    if (requestLine.count() != 3) {
+        respond(socket, 400, errorBody("Malformed request"));
+        return;
+    }
+
+    handleRequest(socket, requestLine.at(0), requestLine.at(1));
+}
+
+void CliServer::onWorkerDone(int index, const QString &json, int error)
+{
+    const Job job = m_running.take(index);
+    const QByteArray body = json.toUtf8();
+
+    const int seconds = cacheSeconds(job.query.command);
+    if (error == CliWorker::NoError && seconds > 0) {
+        CachedResponse *cached = new CachedResponse;
+        cached->body = body;
+        cached->expires = m_clock.elapsed() + seconds * 1000;
+        cached->worker = NULL;
+        if (job.query.command == CliQuery::Journey || job.query.command == CliQuery::Details) {
+            cached->worker = job.worker;
+            cached->idPrefix = job.worker->journeyIdPrefix();
+        }
+        m_cache.insert(job.key, cached, body.size());
+    }
+
+    foreach (const QPointer<QTcpSocket> &socket, m_waiting.take(job.key)) {
+        if (socket)
+            respond(socket, status(error), body);
+    }
+
+    dispatch();
+}
+
+void CliServer::handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &target)
+{
+    if (method != "GET") {
+        respond(socket, 405, errorBody("Only GET is supported"));
+        return;
+    }
+
+    const int queryStart = target.indexOf('?');
+    const QByteArray path = queryStart < 0 ? target : target.left(queryStart);
+    QHash<QString, QString> params;
+    if (queryStart >= 0) {
+        foreach (QByteArray pair, target.mid(queryStart + 1).split('&')) {
+            if (pair.isEmpty())
+                continue;
+            pair.replace('+', ' ');
+            const int eq = pair.indexOf('=');
+            const QString key = QUrl::fromPercentEncoding(eq < 0 ? pair : pair.left(eq));
+            params.insert(key, eq < 0 ? QString() : QUrl::fromPercentEncoding(pair.mid(eq + 1)));
+        }
+    }
+
+    if (path == "/backends") {
+        respond(socket, 200, CliJson::backendList().toUtf8());
+        return;
+    }
+    if (path != "/stations" && path != "/board" && path != "/journey" && path != "/details") {
+        respond(socket, 404, errorBody("Unknown endpoint"));
+        return;
+    }
+
+    Job job;
+    QString error;
+    if (!buildQuery(path, params, &job, &error)) {
+        respond(socket, 400, errorBody(error));
+        return;
+    }
+
+    CachedResponse *cached = m_cache.object(job.key);
+    if (cached && cached->expires > m_clock.elapsed()
+            && (!cached->worker || cached->worker->isJourneyKept(cached->idPrefix))) {
+        respond(socket, 200, cached->body);
+        return;
+    }
+    if (cached)
+        m_cache.remove(job.key);
+
+    // The same request is already running, its response is shared.
+    const bool running = m_waiting.contains(job.key);
+    m_waiting[job.key].append(socket);
+    if (running)
+        return;
+
+    m_queue.append(job);
+    dispatch();
+}
+
+bool CliServer::buildQuery(const QByteArray &path, const QHash<QString, QString> &params, Job *job, QString *error)
+{
+    job->worker = NULL;
+
+    if (path == "/details") {
+        // Ids look like backend.worker.search:id, see CliWorker::setName().
+        const QString id = params.value("id");
+        const QStringList route = id.left(id.indexOf(':')).split('.');
+        CliWorker *worker = NULL;
+        if (id.contains(':') && route.count() == 3)
+            worker = m_pools.value(route.at(0).toInt()).value(route.at(1).toInt());
+        if (!worker) {
+            *error = "Missing or unknown journey id";
+            return false;
+        }
+        job->worker = worker;
+        job->query.command = CliQuery::JourneyDetails;
+        job->query.backend = worker->backend();
+        job->query.journeyId = id;
+        job->key = "details\n" + id;
+        return true;
+    }
+
+    QStringList tokens;
+    if (params.contains("backend"))
+        tokens << "--backend" << params.value("backend");
+    if (params.contains("time"))
+        tokens << "--time" << params.value("time");
+    if (params.contains("restriction"))
+        tokens << "--restriction" << params.value("restriction");
+    if (params.contains("mode")) {
+        const QString mode = params.value("mode");
+        if (mode != "departure" && mode != "arrival") {
+            *error = "mode has to be departure or arrival";
+            return false;
+        }
+        tokens << "--" + mode;
+    }
+
+    if (path == "/stations") {
+        if (params.contains("latitude") && params.contains("longitude"))
+            tokens << "nearby" << params.value("latitude") << params.value("longitude");
+        else if (params.contains("name"))
+            tokens << "stations" << params.value("name");
+        else {
+            *error = "name or latitude and longitude are required";
+            return false;
+        }
+    } else if (path == "/board") {
+        if (!params.contains("station")) {
+            *error = "station is required";
+            return false;
+        }
+        tokens << "board" << params.value("station");
+        if (params.contains("direction"))
+            tokens << params.value("direction");
+    } else {
+        if (!params.contains("from") || !params.contains("to")) {
+            *error = "from and to are required";
+            return false;
+        }
+        tokens << "journey" << params.value("from") << params.value("to");
+        if (params.contains("via"))
+            tokens << params.value("via");
+    }
+
+    CliQuery &query = job->query;
+    if (!query.parse(tokens, error))
+        return false;
+
+    // Now is taken to the minute, so clients asking at about the same time
+    // share one response.
+    if (!query.dateTime.isValid()) {
+        const QDateTime now = QDateTime::currentDateTime();
+        query.dateTime = QDateTime(now.date(), QTime(now.time().hour(), now.time().minute()));
+    }
+
+    QStringList key;
+    key << CliQuery::commandName(query.command) << QString::number(query.backend) << QString::number(query.mode)
+        << QString::number(query.trainrestrictions) << query.dateTime.toString(Qt::ISODate)
+        << QString::number(query.latitude, 'g', 10) << QString::number(query.longitude, 'g', 10) << query.stations;
+    job->key = key.join("\n");
+    return true;
+}
+
+CliWorker *CliServer::idleWorker(int backend)
+{
+    QList<CliWorker *> &pool = m_pools[backend];
+    foreach (CliWorker *worker, pool) {
+        if (!worker->isBusy())
+            return worker;
+    }
+    if (pool.count() >= m_poolSize)
+        return NULL;
+
+    CliWorker *worker = new CliWorker(&m_stationCache, m_timeout, this);
+    worker->setName(QString("%1.%2").arg(backend).arg(pool.count()));
+    connect(worker, SIGNAL(done(int,QString,int)), SLOT(onWorkerDone(int,QString,int)));
+    pool.append(worker);
+    return worker;
+}
+
+void CliServer::dispatch()
+{
+    // Workers may finish right away, which dispatches again.
+    if (m_dispatching) {
+        m_dispatchAgain = true;
+        return;
+    }
+
+    m_dispatching = true;
+    bool started;
+    do {
+        m_dispatchAgain = false;
+        started = false;
+        for (int i = 0; i < m_queue.count(); ++i) {
+            const Job &job = m_queue.at(i);
+            CliWorker *worker = job.worker ? job.worker : idleWorker(job.query.backend);
+            if (!worker || worker->isBusy())
+                continue;
+
+            Job running = m_queue.takeAt(i);
+            running.worker = worker;
+
+            const int index = m_nextIndex++;
+            m_running.insert(index, running);
+            worker->run(index, running.query);
+            started = true;
+            break;
+        }
+    } while (started || m_dispatchAgain);
+    m_dispatching = false;
+}
+
+int CliServer::cacheSeconds(CliQuery::Command command)
+{
+    switch (command) {
+    case CliQuery::Stations:
+    case CliQuery::Nearby:
+        return 3600;
+    case CliQuery::Board:
+        return 30;
+    case CliQuery::Journey:
+        return 60;
+    case CliQuery::JourneyDetails:
+        return 300;
+    default:
+        return 0;
+    }
+}
+
+// Failures the caller can fix are 4xx, those of the backend stay 502.
+int CliServer::status(int error)
+{
+    switch (error) {
+    case CliWorker::NoError:
+        return 200;
+    case CliWorker::Unsupported:
+        return 400;
+    case CliWorker::NotFound:
+        return 404;
+    case CliWorker::Expired:
+        return 410;
+    default:
+        return 502;
+    }
+}
+
+void CliServer::respond(QTcpSocket *socket, int status, const QByteArray &body)
+{
+    QByteArray reason;
+    switch (status) {
+    case 200:
+        reason = "OK";
+        break;
+    case 400:
+        reason = "Bad Request";
+        break;
+    case 404:
+        reason = "Not Found";
+        break;
+    case 405:
+        reason = "Method Not Allowed";
+        break;
+    case 410:
+        reason = "Gone";
+        break;
+    default:
+        reason = "Bad Gateway";
+        break;
+    }
+
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + reason + "\r\n"
+            "Content-Type: application/json; charset=utf-8\r\n"
+            "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+            "Connection: close\r\n"
+            "\r\n";
+    response += body;
+
+    socket->write(response);
+    socket->disconnectFromHost();
+}
+
+QByteArray CliServer::errorBody(const QString &error)
+{
+    return "{\"ok\":false,\"error\":" + CliJson::string(error).toUtf8() + "}";
+}
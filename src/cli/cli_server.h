@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef CLI_SERVER_H
+#define CLI_SERVER_H
+
+#include "cli_query.h"
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QPointer>
+#include <QTcpServer>
+
+class CliWorker;
+class QTcpSocket;
+
+/**
+ * @brief Local HTTP/JSON service of fahrplan-cli --serve.
+ * Each backend gets a pool of workers, started on first use and kept
+ * running, so the backend connections stay warm. Responses are cached and
+ * shared by all clients, identical requests which are still running are
+ * answered together.
+ *
+ * GET /backends
+ * GET /stations?name=...  or  /stations?latitude=...&longitude=...
+ * GET /board?station=...[&direction=...]
+ * GET /journey?from=...&to=...[&via=...]
+ * GET /details?id=...     with an id of one of the last
+ *                          CliWorker::KeptSearches searches of its worker
+ *
+ * All but /backends and /details take backend, time (yyyy-MM-ddTHH:mm),
+ * mode (departure or arrival) and restriction like the command line.
+ */
+class CliServer : public QObject
+{
+    Q_OBJECT
+
+    public:
+        CliServer(int poolSize, int timeout, QObject *parent = 0);
+
+        bool listen(const QHostAddress &address, quint16 port);
+        QString errorString() const;
+
+    private slots:
+        void onNewConnection();
+        void onReadyRead();
+        void onWorkerDone(int index, const QString &json, int error);
+
+    private:
+        struct Job {
+            QString key;
+            CliQuery query;
+            // Set for details, only the worker of the search knows the id.
+            // Set to the worker running it once dispatched.
+            CliWorker *worker;
+        };
+
+        struct CachedResponse {
+            QByteArray body;
+            qint64 expires;
+            // Set for journeys, their ids expire with the search.
+            CliWorker *worker;
+            QString idPrefix;
+        };
+
+        QTcpServer m_server;
+        int m_poolSize;
+        int m_timeout;
+        QHash<int, QList<CliWorker *> > m_pools;
+        QHash<QString, Station> m_stationCache;
+        QList<Job> m_queue;
+        QHash<int, Job> m_running;
+        QHash<QString, QList<QPointer<QTcpSocket> > > m_waiting;
+        QCache<QString, CachedResponse> m_cache;
+        QElapsedTimer m_clock;
+        int m_nextIndex;
+        bool m_dispatching;
+        bool m_dispatchAgain;
+
+        void handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &target);
+        bool buildQuery(const QByteArray &path, const QHash<QString, QString> &params, Job *job, QString *error);
+        CliWorker *idleWorker(int backend);
+        void dispatch();
+        static int cacheSeconds(CliQuery::Command command);
+        static int status(int error);
+        static void respond(QTcpSocket *socket, int status, const QByteArray &body);
+        static QByteArray errorBody(const QString &error);
+};
+
+#endif // CLI_SERVER_H
@@ -0,0 +1,210 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "cli_json.h"
+#include "cli_query.h"
+#include "cli_runner.h"
+#include "cli_server.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+
+#include <cstdio>
+
+static void printUsage(QTextStream &out)
+{
+    out << "Usage: fahrplan-cli [options] [command arguments...]\n"
+           "       fahrplan-cli --serve <port> [--listen <address>] [--jobs <count>]\n"
+           "\n"
+           "Commands:\n"
+           "  stations <name>                 Find stations by name\n"
+           "  nearby <latitude> <longitude>   Find stations around a position\n"
+           "  board <station> [<direction>]   Departures or arrivals of a station\n"
+           "  journey <from> <to> [<via>]     Search journeys\n"
+           "  details <from> <to> [<via>]     Details of the first journey found\n"
+           "\n"
+           "Options:\n"
+           "  -b, --backend <backend>         Index, uid or name of the backend (default 0)\n"
+           "  -t, --time <yyyy-MM-ddTHH:mm>   Time of the board or journey (default now)\n"
+           "  -a, --arrival                   Search by arrival time\n"
+           "  -d, --departure                 Search by departure time (default)\n"
+           "  -r, --restriction <index>       Train restriction of the backend (default 0)\n"
+           "  -f, --file <file>               Read one query per line, - for stdin\n"
+           "  -j, --jobs <count>              Queries run at the same time (default 1)\n"
+           "      --timeout <msecs>           Timeout of each request (default 30000)\n"
+           "  -l, --list-backends             Print the available backends\n"
+           "      --serve <port>              Serve the queries as HTTP/JSON service, with\n"
+           "                                  --jobs workers per backend\n"
+           "      --listen <address>          Address to serve on (default 127.0.0.1)\n"
+           "  -h, --help                      Print this help\n"
+           "\n"
+           "Lines of a query file are written like the command line and may contain\n"
+           "the query options above, the command line options are their defaults.\n"
+           "Empty lines and lines starting with # are skipped. Each result is printed\n"
+           "as one line of JSON, in the order of the queries.\n"
+           "\n"
+           "Service endpoints, parameters are named like the options and arguments:\n"
+           "  GET /backends\n"
+           "  GET /stations?name=...  or  /stations?latitude=...&longitude=...\n"
+           "  GET /board?station=...[&direction=...]\n"
+           "  GET /journey?from=...&to=...[&via=...]\n"
+           "  GET /details?id=<journey id>\n"
+           "Journey ids of the last 3 searches of each worker stay valid.\n";
+    out.flush();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    out.setCodec("UTF-8");
+    err.setCodec("UTF-8");
+
+    qRegisterMetaType<Station>();
+    qRegisterMetaType<StationsList>();
+    qRegisterMetaType<TimetableEntry>();
+    qRegisterMetaType<TimetableEntriesList>();
+    qRegisterMetaType<JourneyResultList *>("JourneyResultList*");
+    qRegisterMetaType<JourneyDetailResultList *>("JourneyDetailResultList*");
+
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    QStringList queryArgs;
+    QString fileName;
+    QHostAddress address(QHostAddress::LocalHost);
+    int port = -1;
+    int jobs = 1;
+    int timeout = 30000;
+    for (int i = 0; i < args.count(); ++i) {
+        const QString &arg = args.at(i);
+        if (arg == "-h" || arg == "--help") {
+            printUsage(out);
+            return 0;
+        }
+        if (arg == "-l" || arg == "--list-backends") {
+            out << CliJson::backendList() << '\n';
+            return 0;
+        }
+        if (arg == "-f" || arg == "--file" || arg == "-j" || arg == "--jobs" || arg == "--timeout"
+                || arg == "--serve" || arg == "--listen") {
+            if (i + 1 >= args.count()) {
+                err << "Missing value for " << arg << '\n';
+                return 2;
+            }
+            const QString value = args.at(++i);
+            bool ok = true;
+            if (arg == "-f" || arg == "--file")
+                fileName = value;
+            else if (arg == "--listen")
+                ok = address.setAddress(value);
+            else if (arg == "--serve")
+                port = value.toInt(&ok);
+            else if (arg == "--timeout")
+                timeout = value.toInt(&ok);
+            else
+                jobs = value.toInt(&ok);
+            if (!ok) {
+                err << "Invalid value " << value << " for " << arg << '\n';
+                return 2;
+            }
+            continue;
+        }
+        queryArgs << arg;
+    }
+
+    if (port >= 0) {
+        if (!queryArgs.isEmpty() || !fileName.isEmpty()) {
+            err << "Queries can not be given together with --serve\n";
+            return 2;
+        }
+
+        CliServer server(jobs, timeout);
+        if (!server.listen(address, port)) {
+            err << "Can not listen on " << address.toString() << ":" << port << ": " << server.errorString() << '\n';
+            return 1;
+        }
+        err << "Listening on " << address.toString() << ":" << port << '\n';
+        err.flush();
+
+        return app.exec();
+    }
+
+    QString error;
+    CliQuery defaults;
+    if (!defaults.parse(queryArgs, &error)) {
+        err << error << '\n';
+        return 2;
+    }
+
+    CliRunner runner(&out);
+    runner.setConcurrency(jobs);
+    runner.setTimeout(timeout);
+
+    int queries = 0;
+    if (defaults.command != CliQuery::None) {
+        runner.addQuery(defaults);
+        ++queries;
+    }
+
+    if (!fileName.isEmpty()) {
+        QFile file(fileName);
+        const bool opened = fileName == "-" ? file.open(stdin, QIODevice::ReadOnly) : file.open(QIODevice::ReadOnly);
+        if (!opened) {
+            err << "Can not open " << fileName << ": " << file.errorString() << '\n';
+            return 2;
+        }
+
+        QTextStream in(&file);
+        in.setCodec("UTF-8");
+        int lineNumber = 0;
+        while (!in.atEnd()) {
+            const QString line = in.readLine().trimmed();
+            ++lineNumber;
+            if (line.isEmpty() || line.startsWith('#'))
+                continue;
+
+            CliQuery query = defaults;
+            query.command = CliQuery::None;
+            query.stations.clear();
+            if (!query.parse(CliQuery::split(line), &error) || query.command == CliQuery::None) {
+                err << fileName << ":" << lineNumber << ": " << (error.isEmpty() ? QString("Missing command") : error) << '\n';
+                return 2;
+            }
+            runner.addQuery(query);
+            ++queries;
+        }
+    }
+
+    if (queries == 0) {
+        printUsage(err);
+        return 2;
+    }
+
+    QObject::connect(&runner, SIGNAL(finished()), &app, SLOT(quit()));
+    QTimer::singleShot(0, &runner, SLOT(start()));
+    app.exec();
+
+    return runner.exitCode();
+}
@@ -20,61 +20,158 @@
 #include "fahrplan.h"
 #include "fahrplan_parser_thread.h"
 #include "fahrplan_backend_manager.h"
+#include "fahrplan_federated_search.h"
+#include "fahrplan_settings.h"
+#include "fahrplan_stations_store.h"
+#include "fahrplan_startup.h"
 #include "calendarthreadwrapper.h"
 #include "models/favorites.h"
 #include "models/stationsearchresults.h"
+#include "models/stationsuggestions.h"
 #include "models/timetable.h"
 #include "models/trainrestrictions.h"
+#include "parser/parser_registry.h"
 
+#include <QEvent>
 #include <QThread>
+#include <QTimer>
+#if defined(BUILD_FOR_QT5)
+#include <QGuiApplication>
+#else
+#include <QCoreApplication>
+#endif
 
-FahrplanBackendManager *Fahrplan::m_parser_manager = NULL;
-StationSearchResults *Fahrplan::m_stationSearchResults= NULL;
-Favorites *Fahrplan::m_favorites = NULL;
-Timetable *Fahrplan::m_timetable = NULL;
-Trainrestrictions *Fahrplan::m_trainrestrictions = NULL;
+// Bounds of the live departure board refresh interval, in seconds.
+static const int LIVE_TIMETABLE_MIN_INTERVAL = 30;
+static const int LIVE_TIMETABLE_MAX_INTERVAL = 300;
+
+// Favorites and recent stations are the same for every session.
+FahrplanStationsStore *Fahrplan::m_stationsStore = NULL;
 
 Fahrplan::Fahrplan(QObject *parent)
     : QObject(parent)
+    , m_recentsRequest(0)
     , m_departureStation(Station(false))
     , m_viaStation(Station(false))
     , m_arrivalStation(Station(false))
     , m_trainrestriction(0)
     , m_mode(DepartureMode)
     , m_dateTime(QDateTime::currentDateTime())
+    , m_liveTimetable(false)
+    , m_applicationActive(true)
+    , m_timetablePending(false)
+    , m_unchangedRefreshes(0)
 {
-    settings = new QSettings(FAHRPLAN_SETTINGS_NAMESPACE, "fahrplan2");
+    settings = FahrplanSettings::instance();
     setMode(static_cast<Mode>(settings->value("mode", DepartureMode).toInt()));
 
-    if (!m_parser_manager) {
-        int currentBackend = settings->value("currentBackend", 0).toInt();
-        m_parser_manager = new FahrplanBackendManager(currentBackend);
+    // Backends are stored by uid, indexes depend on the backends built.
+    migrateBackendSettings();
+    init(qMax(0, ParserRegistry::indexOf(settings->value("currentBackendUid").toString())));
+
+    QList<int> backends;
+    foreach (const QString &uid, settings->value("federatedBackendUids").toStringList()) {
+        const int index = ParserRegistry::indexOf(uid);
+        if (index >= 0)
+            backends.append(index);
+    }
+    m_federatedSearch->setBackends(backends);
+}
+
+// Older versions stored the registry index, which points to another
+// backend once the set of built backends changes. Converted once.
+void Fahrplan::migrateBackendSettings()
+{
+    if (settings->contains("currentBackend")) {
+        const int index = settings->value("currentBackend").toInt();
+        if (!settings->contains("currentBackendUid") && index >= 0 && index < ParserRegistry::count())
+            settings->setValue("currentBackendUid", QString::fromLatin1(ParserRegistry::info(index).uid));
+        settings->remove("currentBackend");
+    }
+
+    if (settings->contains("federatedBackends")) {
+        QStringList uids;
+        foreach (const QVariant &index, settings->value("federatedBackends").toList()) {
+            if (index.toInt() >= 0 && index.toInt() < ParserRegistry::count())
+                uids.append(QString::fromLatin1(ParserRegistry::info(index.toInt()).uid));
+        }
+        if (!settings->contains("federatedBackendUids"))
+            settings->setValue("federatedBackendUids", uids);
+        settings->remove("federatedBackends");
     }
+}
+
+void Fahrplan::init(int backend)
+{
+    m_parser_manager = new FahrplanBackendManager(backend, this);
     connect(m_parser_manager, SIGNAL(parserChanged(const QString &, int)), this, SLOT(onParserChanged(const QString &, int)));
 
-    if (!m_favorites) {
-        m_favorites = new Favorites(this);
+    if (!m_stationsStore) {
+        // Owned by the application, so pending writes are done on exit.
+        m_stationsStore = new FahrplanStationsStore(QCoreApplication::instance());
     }
+
+    m_favorites = new Favorites(this);
     connect(m_favorites, SIGNAL(stationSelected(Fahrplan::StationType,Station))
-            , SLOT(setStation(Fahrplan::StationType,Station)));
+            , SLOT(onStationSelected(Fahrplan::StationType,Station)));
 
-    if (!m_stationSearchResults) {
-        m_stationSearchResults = new StationSearchResults(this);
-    }
+    m_stationSearchResults = new StationSearchResults(this);
     connect(m_stationSearchResults, SIGNAL(stationSelected(Fahrplan::StationType,Station))
-            , SLOT(setStation(Fahrplan::StationType,Station)));
+            , SLOT(onStationSelected(Fahrplan::StationType,Station)));
+
+    m_stationSuggestions = new StationSuggestions(this);
+    connect(m_stationSuggestions, SIGNAL(stationSelected(Fahrplan::StationType,Station))
+            , SLOT(onStationSelected(Fahrplan::StationType,Station)));
+    connect(m_stationsStore, SIGNAL(recentsLoaded(int,QString,StationsList))
+            , SLOT(onRecentsLoaded(int,QString,StationsList)));
+
+    m_timetable = new Timetable(this);
+    m_trainrestrictions = new Trainrestrictions(this);
+
+    m_federatedSearch = new FahrplanFederatedSearch(this);
+    connect(m_federatedSearch, SIGNAL(journeyResult(JourneyResultList*)), SIGNAL(parserJourneyResult(JourneyResultList*)));
+    connect(m_federatedSearch, SIGNAL(journeyDetailsResult(JourneyDetailResultList*)), SIGNAL(parserJourneyDetailsResult(JourneyDetailResultList*)));
+    connect(m_federatedSearch, SIGNAL(errorOccured(QString)), SIGNAL(parserErrorOccured(QString)));
+
+    m_liveTimer = new QTimer(this);
+    m_liveTimer->setSingleShot(true);
+    connect(m_liveTimer, SIGNAL(timeout()), SLOT(refreshTimetable()));
+    connect(this, SIGNAL(parserErrorOccured(QString)), SLOT(onParserErrorOccured()));
+
+    // Live boards are not refreshed while the application is in background.
+#if defined(BUILD_FOR_QT5)
+    if (qobject_cast<QGuiApplication *>(QCoreApplication::instance()))
+        connect(QCoreApplication::instance(), SIGNAL(applicationStateChanged(Qt::ApplicationState)), SLOT(onApplicationStateChanged(Qt::ApplicationState)));
+#else
+    if (QCoreApplication::instance())
+        QCoreApplication::instance()->installEventFilter(this);
+#endif
 
-    if (!m_timetable) {
-        m_timetable = new Timetable(this);
-    }
+    // The parser, and with it favorites and recent stations, is only set up
+    // after the first frame, unless the UI asks for it earlier.
+    FahrplanStartup *startup = FahrplanStartup::instance();
+    if (startup->isInteractive())
+        QTimer::singleShot(0, this, SLOT(completeStartup()));
+    else
+        connect(startup, SIGNAL(interactive()), SLOT(completeStartup()));
+}
 
-    if (!m_trainrestrictions) {
-        m_trainrestrictions = new Trainrestrictions(this);
-    }
+void Fahrplan::completeStartup()
+{
+    m_parser_manager->getParser();
+    FahrplanStartup::mark("Parser created");
 }
 
 void Fahrplan::bindParserSignals()
 {
+    // Parser threads are reused when switching back to a backend, so the
+    // previous one has to be detached or its late replies would show up.
+    if (m_boundParser) {
+        m_boundParser->cancelRequest();
+        disconnect(m_boundParser, 0, this, 0);
+    }
+    m_boundParser = m_parser_manager->getParser();
+
     if (m_parser_manager->getParser()) {
         connect(m_parser_manager->getParser(), SIGNAL(stationsResult(StationsList)), this, SLOT(onStationSearchResults(StationsList)));
         connect(m_parser_manager->getParser(), SIGNAL(journeyResult(JourneyResultList*)), this, SIGNAL(parserJourneyResult(JourneyResultList*)));
@@ -104,6 +201,16 @@ Favorites* Fahrplan::favorites() const
     return m_favorites;
 }
 
+StationSuggestions *Fahrplan::stationSuggestions() const
+{
+    return m_stationSuggestions;
+}
+
+FahrplanStationsStore *Fahrplan::stationsStore() const
+{
+    return m_stationsStore;
+}
+
 QString Fahrplan::getVersion()
 {
     return FAHRPLAN_VERSION;
@@ -111,11 +218,8 @@ QString Fahrplan::getVersion()
 
 bool Fahrplan::supportsCalendar()
 {
-#if defined(BUILD_FOR_BLACKBERRY) || defined(BUILD_FOR_HARMATTAN) || defined(BUILD_FOR_MAEMO_5) || defined(BUILD_FOR_SYMBIAN) || (defined(BUILD_FOR_OPENREPOS) && defined(BUILD_FOR_SAILFISHOS))
+    // Builds without a calendar backend write an iCalendar file instead.
     return true;
-#else
-    return false;
-#endif
 }
 
 StationSearchResults *Fahrplan::stationSearchResults() const
@@ -204,6 +308,113 @@ void Fahrplan::setDateTime(const QDateTime &dateTime)
     emit dateTimeChanged();
 }
 
+QVariantList Fahrplan::federatedBackends() const
+{
+    QVariantList result;
+    foreach (int index, m_federatedSearch->backends())
+        result.append(index);
+    return result;
+}
+
+bool Fahrplan::liveTimetable() const
+{
+    return m_liveTimetable;
+}
+
+void Fahrplan::setLiveTimetable(bool live)
+{
+    if (live == m_liveTimetable)
+        return;
+
+    m_liveTimetable = live;
+    m_unchangedRefreshes = 0;
+    emit liveTimetableChanged();
+
+    if (!live)
+        m_liveTimer->stop();
+    else if (!m_timetablePending && m_timetable->count() > 0)
+        scheduleTimetableRefresh(true);
+}
+
+/*
+ * Plans the next refresh of a live board. Boards are refreshed more often
+ * shortly before the next departure, and less often each time a refresh
+ * did not change anything.
+ */
+void Fahrplan::scheduleTimetableRefresh(bool changed)
+{
+    if (!m_liveTimetable)
+        return;
+
+    m_unchangedRefreshes = changed ? 0 : qMin(m_unchangedRefreshes + 1, 3);
+
+    const int next = m_timetable->secsToNextDeparture();
+    int interval = next < 0 ? LIVE_TIMETABLE_MAX_INTERVAL : qBound(LIVE_TIMETABLE_MIN_INTERVAL, next / 2, LIVE_TIMETABLE_MAX_INTERVAL);
+    interval = qMin(interval << m_unchangedRefreshes, LIVE_TIMETABLE_MAX_INTERVAL);
+
+    if (m_applicationActive)
+        m_liveTimer->start(interval * 1000);
+}
+
+void Fahrplan::refreshTimetable()
+{
+    if (m_liveTimetable && m_applicationActive && !m_timetablePending)
+        getTimeTable();
+}
+
+void Fahrplan::setApplicationActive(bool active)
+{
+    if (active == m_applicationActive)
+        return;
+
+    m_applicationActive = active;
+    if (!active) {
+        m_liveTimer->stop();
+        return;
+    }
+
+    // The board went stale in background, refresh it right away.
+    if (m_liveTimetable && m_timetable->count() > 0)
+        refreshTimetable();
+}
+
+#if defined(BUILD_FOR_QT5)
+void Fahrplan::onApplicationStateChanged(Qt::ApplicationState state)
+{
+    setApplicationActive(state == Qt::ApplicationActive);
+}
+#endif
+
+bool Fahrplan::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::ApplicationActivate)
+        setApplicationActive(true);
+    else if (event->type() == QEvent::ApplicationDeactivate)
+        setApplicationActive(false);
+
+    return QObject::eventFilter(watched, event);
+}
+
+void Fahrplan::setFederatedBackends(const QVariantList &backends)
+{
+    QList<int> indexes;
+    foreach (const QVariant &index, backends) {
+        if (!indexes.contains(index.toInt()))
+            indexes.append(index.toInt());
+    }
+
+    if (indexes == m_federatedSearch->backends())
+        return;
+
+    m_federatedSearch->setBackends(indexes);
+
+    QStringList uids;
+    foreach (int index, indexes)
+        uids.append(QString::fromLatin1(ParserRegistry::info(index).uid));
+    settings->setValue("federatedBackendUids", uids);
+    emit federatedBackendsChanged();
+}
+
 bool Fahrplan::timeFormat24h() const
 {
     // A hacky way to detect whether locale uses 24 or 12 hour time format.
@@ -241,6 +452,16 @@ void Fahrplan::setStation(Fahrplan::StationType type, const Station &station)
     }
 }
 
+void Fahrplan::onStationSelected(Fahrplan::StationType type, const Station &station)
+{
+    if (station.valid) {
+        const QString backend = m_parser_manager->getParser()->uid();
+        m_stationsStore->addRecent(backend, station);
+        m_recentsRequest = m_stationsStore->loadRecents(backend);
+    }
+    setStation(type, station);
+}
+
 void Fahrplan::swapStations(StationType type1, StationType type2)
 {
     if (type1 == type2)
@@ -278,9 +499,46 @@ void Fahrplan::searchJourney()
         mode = ParserAbstract::Mode(m_mode);
     }
 
+    if (isFederated()) {
+        m_federatedSearch->searchJourney(m_parser_manager->parserIndex(), m_departureStation, m_viaStation, m_arrivalStation, m_dateTime, mode, m_trainrestriction);
+        return;
+    }
+
+    // Ids of earlier merged results must not catch the details of this one.
+    m_federatedSearch->clearResults();
     m_parser_manager->getParser()->searchJourney(m_departureStation, m_viaStation, m_arrivalStation, m_dateTime, mode, m_trainrestriction);
 }
 
+void Fahrplan::searchJourneyLater()
+{
+    if (isFederated())
+        m_federatedSearch->searchJourneyLater();
+    else
+        m_parser_manager->getParser()->searchJourneyLater();
+}
+
+void Fahrplan::searchJourneyEarlier()
+{
+    if (isFederated())
+        m_federatedSearch->searchJourneyEarlier();
+    else
+        m_parser_manager->getParser()->searchJourneyEarlier();
+}
+
+void Fahrplan::getJourneyDetails(const QString &id)
+{
+    // Ids of merged results are only known to the federated search.
+    if (!m_federatedSearch->getJourneyDetails(id))
+        m_parser_manager->getParser()->getJourneyDetails(id);
+}
+
+void Fahrplan::cancelRequest()
+{
+    m_timetablePending = false;
+    m_federatedSearch->cancelRequest();
+    m_parser_manager->getParser()->cancelRequest();
+}
+
 void Fahrplan::getTimeTable()
 {
     ParserAbstract::Mode mode;
@@ -292,6 +550,8 @@ void Fahrplan::getTimeTable()
         mode = ParserAbstract::Mode(m_mode);
     }
 
+    m_liveTimer->stop();
+    m_timetablePending = true;
     m_parser_manager->getParser()->getTimeTableForStation(m_currentStation, m_directionStation, m_dateTime, mode, m_trainrestriction);
 }
 
@@ -315,6 +575,8 @@ void Fahrplan::onParserChanged(const QString &name, int index)
     //We need to reconnect all Signals to the new Parser
     bindParserSignals();
     m_stationSearchResults->setStationsList(StationsList());
+    m_stationSuggestions->setSuggestions(StationsList());
+    m_recentsRequest = m_stationsStore->loadRecents(parser()->uid());
     loadStations();
     if (m_favorites)
         m_favorites->reload();
@@ -335,20 +597,46 @@ void Fahrplan::onStationSearchResults(const StationsList &result)
     emit parserStationsResult();
 }
 
+void Fahrplan::onRecentsLoaded(int request, const QString &backend, const StationsList &recents)
+{
+    // The store is shared, loads of other instances are none of ours.
+    if (request == m_recentsRequest && backend == m_parser_manager->getParser()->uid())
+        m_stationSuggestions->setSuggestions(recents);
+}
+
 void Fahrplan::onTimetableResult(const TimetableEntriesList &timetableEntries)
 {
-    m_timetable->setTimetableEntries(timetableEntries);
+    const bool changed = m_timetable->setTimetableEntries(timetableEntries);
+
+    if (m_timetablePending) {
+        m_timetablePending = false;
+        scheduleTimetableRefresh(changed);
+    }
 
     emit parserTimeTableResult();
 }
 
+void Fahrplan::onParserErrorOccured()
+{
+    // A failed refresh keeps the board and tries again later.
+    if (m_timetablePending) {
+        m_timetablePending = false;
+        scheduleTimetableRefresh(false);
+    }
+}
+
 QString Fahrplan::parserName() const
 {
+    // Known without the parser, so showing it does not create it.
+    if (!m_parser_manager->hasParser())
+        return ParserRegistry::info(m_parser_manager->parserIndex()).name();
     return m_parser_manager->getParser()->name();
 }
 
 QString Fahrplan::parserShortName() const
 {
+    if (!m_parser_manager->hasParser())
+        return ParserRegistry::info(m_parser_manager->parserIndex()).shortName();
     return m_parser_manager->getParser()->shortName();
 }
 
@@ -357,16 +645,37 @@ QStringList Fahrplan::getParserList()
     return m_parser_manager->getParserList();
 }
 
+int Fahrplan::parserIndex() const
+{
+    return m_parser_manager->parserIndex();
+}
+
 void Fahrplan::setParser(int index)
 {
-    settings->setValue("currentBackend", index);
     m_parser_manager->setParser(index);
+    settings->setValue("currentBackendUid", QString::fromLatin1(ParserRegistry::info(m_parser_manager->parserIndex()).uid));
 }
 
 void Fahrplan::addJourneyDetailResultToCalendar(JourneyDetailResultList *result)
+{
+    startCalendarWrapper(new CalendarThreadWrapper(result));
+}
+
+void Fahrplan::exportJourneyDetailResults(const QVariantList &results, const QString &fileName)
+{
+    QList<JourneyDetailResultList *> lists;
+    foreach (const QVariant &result, results) {
+        JourneyDetailResultList *list = qobject_cast<JourneyDetailResultList *>(result.value<QObject *>());
+        if (list)
+            lists.append(list);
+    }
+
+    startCalendarWrapper(new CalendarThreadWrapper(lists, fileName));
+}
+
+void Fahrplan::startCalendarWrapper(CalendarThreadWrapper *wrapper)
 {
     QThread *workerThread = new QThread(this);
-    CalendarThreadWrapper *wrapper = new CalendarThreadWrapper(result);
 
     connect(workerThread, SIGNAL(started()), wrapper, SLOT(addToCalendar()));
     connect(workerThread, SIGNAL(finished()), wrapper, SLOT(deleteLater()));
@@ -378,6 +687,15 @@ void Fahrplan::addJourneyDetailResultToCalendar(JourneyDetailResultList *result)
     workerThread->start();
 }
 
+bool Fahrplan::isFederated() const
+{
+    foreach (int index, m_federatedSearch->backends()) {
+        if (index != m_parser_manager->parserIndex())
+            return true;
+    }
+    return false;
+}
+
 Station Fahrplan::getStation(StationType type) const
 {
     switch (type) {
@@ -407,38 +725,29 @@ void Fahrplan::loadStations()
 
 void Fahrplan::saveStationToSettings(const QString &key, const Station &station)
 {
-    settings->beginGroup(m_parser_manager->getParser()->uid());
+    const QString group = m_parser_manager->getParser()->uid() + "/" + key;
 
     if (!station.valid) {
-        settings->remove(key);
-        settings->endGroup();
+        settings->remove(group);
         return;
     }
 
-    settings->beginGroup(key);
-    settings->setValue("id", station.id);
-    settings->setValue("name", station.name);
-    settings->endGroup(); // key
-
-    settings->endGroup(); // Parser UID
+    settings->setValue(group + "/id", station.id);
+    settings->setValue(group + "/name", station.name);
 }
 
 Station Fahrplan::loadStationFromSettigns(const QString &key)
 {
     Station station(false);
 
-    settings->beginGroup(m_parser_manager->getParser()->uid());
-    settings->beginGroup(key);
+    const QString group = m_parser_manager->getParser()->uid() + "/" + key;
 
-    station.id = settings->value("id");
+    station.id = settings->value(group + "/id");
     if (station.id.isValid()) {
-        station.name = settings->value("name").toString();
+        station.name = settings->value(group + "/name").toString();
         if (!station.name.isEmpty())
             station.valid = true;
     }
 
-    settings->endGroup(); // key
-    settings->endGroup(); // Parser UID
-
     return station;
 }
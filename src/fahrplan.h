@@ -24,16 +24,22 @@
 #include "parser/parser_abstract.h"
 
 #include <QObject>
-#include <QSettings>
+#include <QPointer>
 #include <QStringList>
 #include <QStringListModel>
 
+class CalendarThreadWrapper;
 class FahrplanBackendManager;
+class FahrplanFederatedSearch;
+class FahrplanSettings;
+class FahrplanStationsStore;
 class FahrplanParserThread;
 class StationSearchResults;
+class StationSuggestions;
 class Timetable;
 class Favorites;
 class Trainrestrictions;
+class QTimer;
 class Fahrplan : public QObject
 {
     Q_OBJECT
@@ -45,6 +51,7 @@ class Fahrplan : public QObject
     Q_PROPERTY(bool supportsCalendar READ supportsCalendar CONSTANT)
 
     Q_PROPERTY(StationSearchResults *stationSearchResults READ stationSearchResults CONSTANT)
+    Q_PROPERTY(StationSuggestions *stationSuggestions READ stationSuggestions CONSTANT)
     Q_PROPERTY(Favorites *favorites READ favorites CONSTANT)
     Q_PROPERTY(Timetable *timetable READ timetable CONSTANT)
     Q_PROPERTY(Trainrestrictions *trainrestrictions READ trainrestrictions CONSTANT)
@@ -57,6 +64,8 @@ class Fahrplan : public QObject
 
     Q_PROPERTY(Mode mode READ mode WRITE setMode NOTIFY modeChanged)
     Q_PROPERTY(QDateTime dateTime READ dateTime WRITE setDateTime NOTIFY dateTimeChanged)
+    Q_PROPERTY(QVariantList federatedBackends READ federatedBackends WRITE setFederatedBackends NOTIFY federatedBackendsChanged)
+    Q_PROPERTY(bool liveTimetable READ liveTimetable WRITE setLiveTimetable NOTIFY liveTimetableChanged)
 
     Q_ENUMS(StationType)
     Q_ENUMS(Mode)
@@ -76,15 +85,20 @@ class Fahrplan : public QObject
             NowMode
         };
 
+        // Restores the session of the user from the settings and saves it
+        // back on changes. Parser threads and the stations store are shared
+        // by all instances.
         explicit Fahrplan(QObject *parent = 0);
         FahrplanParserThread *parser();
         Favorites *favorites() const;
+        FahrplanStationsStore *stationsStore() const;
         QString parserName() const;
         QString parserShortName() const;
         QString getVersion();
         bool supportsCalendar();
 
         StationSearchResults *stationSearchResults() const;
+        StationSuggestions *stationSuggestions() const;
         Timetable *timetable() const;
         Trainrestrictions *trainrestrictions() const;
         QString departureStationName() const;
@@ -100,10 +114,17 @@ class Fahrplan : public QObject
         QDateTime dateTime() const;
         void setDateTime(const QDateTime &dateTime);
 
+        QVariantList federatedBackends() const;
+        void setFederatedBackends(const QVariantList &backends);
+
+        bool liveTimetable() const;
+        void setLiveTimetable(bool live);
+
         Q_INVOKABLE bool timeFormat24h() const;
 
     public slots:
         QStringList getParserList();
+        int parserIndex() const;
         void setParser(int index);
         void storeSettingsValue(const QString &key, const QString &value);
         QString getSettingsValue(const QString &key, const QString &defaultValue);
@@ -113,7 +134,14 @@ class Fahrplan : public QObject
         void findStationsByCoordinates(qreal longitude, qreal latitude);
         void getTimeTable();
         void searchJourney();
+        void searchJourneyLater();
+        void searchJourneyEarlier();
+        void getJourneyDetails(const QString &id);
+        void cancelRequest();
         void addJourneyDetailResultToCalendar(JourneyDetailResultList *result);
+        // Adds all given JourneyDetailResultLists in one batch, to an
+        // iCalendar file if fileName is set, else to the selected calendar.
+        void exportJourneyDetailResults(const QVariantList &results, const QString &fileName = QString());
         void setTrainrestriction(int index);
 
     signals:
@@ -126,6 +154,8 @@ class Fahrplan : public QObject
 
         void modeChanged();
         void dateTimeChanged();
+        void federatedBackendsChanged();
+        void liveTimetableChanged();
 
         void parserStationsResult();
         void parserJourneyResult(JourneyResultList *result);
@@ -137,18 +167,35 @@ class Fahrplan : public QObject
 
     private slots:
         void setStation(Fahrplan::StationType type, const Station &station);
+        void onStationSelected(Fahrplan::StationType type, const Station &station);
         void onParserChanged(const QString &name, int index);
+        void completeStartup();
         void onStationSearchResults(const StationsList &result);
+        void onRecentsLoaded(int request, const QString &backend, const StationsList &recents);
         void onTimetableResult(const TimetableEntriesList &timetableEntries);
         void bindParserSignals();
+        void onParserErrorOccured();
+        void refreshTimetable();
+#if defined(BUILD_FOR_QT5)
+        void onApplicationStateChanged(Qt::ApplicationState state);
+#endif
+
+    protected:
+        bool eventFilter(QObject *watched, QEvent *event);
 
     private:
-        static FahrplanBackendManager *m_parser_manager;
-        static StationSearchResults *m_stationSearchResults;
-        static Favorites *m_favorites;
-        static Timetable *m_timetable;
-        static Trainrestrictions *m_trainrestrictions;
-        QSettings *settings;
+        FahrplanBackendManager *m_parser_manager;
+        StationSearchResults *m_stationSearchResults;
+        StationSuggestions *m_stationSuggestions;
+        Favorites *m_favorites;
+        Timetable *m_timetable;
+        Trainrestrictions *m_trainrestrictions;
+        FahrplanFederatedSearch *m_federatedSearch;
+        static FahrplanStationsStore *m_stationsStore;
+        FahrplanSettings *settings;
+        // Recents load in flight, others are ignored
+        int m_recentsRequest;
+        QPointer<FahrplanParserThread> m_boundParser;
 
         Station m_departureStation;
         Station m_viaStation;
@@ -160,10 +207,23 @@ class Fahrplan : public QObject
         Mode m_mode;
         QDateTime m_dateTime;
 
+        // Live departure board
+        QTimer *m_liveTimer;
+        bool m_liveTimetable;
+        bool m_applicationActive;
+        bool m_timetablePending;
+        int m_unchangedRefreshes;
+
+        void init(int backend);
+        void migrateBackendSettings();
+        bool isFederated() const;
         Station getStation(StationType type) const;
         void loadStations();
         void saveStationToSettings(const QString &key, const Station &station);
         Station loadStationFromSettigns(const QString &key);
+        void scheduleTimetableRefresh(bool changed);
+        void startCalendarWrapper(CalendarThreadWrapper *wrapper);
+        void setApplicationActive(bool active);
 };
 Q_DECLARE_METATYPE(Fahrplan::StationType)
 Q_DECLARE_METATYPE(Fahrplan::Mode)
@@ -18,6 +18,8 @@
 ****************************************************************************/
 
 #include "fahrplan_backend_manager.h"
+#include "fahrplan_parser_pool.h"
+#include "parser/parser_registry.h"
 
 FahrplanBackendManager::FahrplanBackendManager(int defaultParser, QObject *parent) :
     QObject(parent)
@@ -26,25 +28,14 @@ FahrplanBackendManager::FahrplanBackendManager(int defaultParser, QObject *paren
     currentParserIndex = defaultParser;
 }
 
+FahrplanBackendManager::~FahrplanBackendManager()
+{
+    FahrplanParserPool::instance()->release(m_parser, this);
+}
+
 QStringList FahrplanBackendManager::getParserList()
 {
-    QStringList result;
-    result.append(ParserMobileBahnDe::getName());
-    result.append(ParserXmlOebbAt::getName());
-    result.append(ParserXmlRejseplanenDk::getName());
-    result.append(ParserXmlSbbCh::getName());
-    result.append(ParserXmlNri::getName());
-    result.append(ParserXmlVasttrafikSe::getName());
-    result.append(ParserPTVVicGovAu::getName());
-    result.append(ParserSydneyEFA::getName());
-    result.append(ParserSFBayEFA::getName());
-    result.append(ParserIrelandEFA::getName());
-    result.append(ParserDubaiEFA::getName());
-    result.append(ParserNinetwo::getName());
-    result.append(ParserMunichEFA::getName());
-    result.append(ParserSalzburgEFA::getName());
-    result.append(ParserResRobot::getName());
-    return result;
+    return ParserRegistry::names();
 }
 
 FahrplanParserThread *FahrplanBackendManager::getParser()
@@ -55,21 +46,34 @@ FahrplanParserThread *FahrplanBackendManager::getParser()
     return m_parser;
 }
 
+bool FahrplanBackendManager::hasParser() const
+{
+    return m_parser != NULL;
+}
+
+int FahrplanBackendManager::parserIndex() const
+{
+    return currentParserIndex;
+}
+
 void FahrplanBackendManager::setParser(int index)
 {
+    // Stored indexes may point past the backends of this build.
+    if (index < 0 || index >= ParserRegistry::count()) {
+        index = 0;
+    }
+
     if (currentParserIndex == index && m_parser) {
         return;
     }
 
     currentParserIndex = index;
 
-    if (m_parser) {
-        // Parser object will be autodeleted after the thread quits.
-        m_parser->quit();
-    }
-
-    m_parser = new FahrplanParserThread();
-    m_parser->init(index);
+    // Switching back to a recently used backend keeps its network
+    // connections and paging context.
+    FahrplanParserPool *pool = FahrplanParserPool::instance();
+    pool->release(m_parser, this);
+    m_parser = pool->acquire(index, this);
 
     emit parserChanged(m_parser->name(), currentParserIndex);
 }
@@ -28,9 +28,12 @@ class FahrplanBackendManager : public QObject
 
     public:
         explicit FahrplanBackendManager(int defaultParser, QObject *parent = 0);
+        ~FahrplanBackendManager();
         QStringList getParserList();
         void setParser(int index);
         FahrplanParserThread *getParser();
+        bool hasParser() const;
+        int parserIndex() const;
 
     signals:
         void parserChanged(QString name, int index);
@@ -19,7 +19,7 @@
 
 #include "fahrplan_calendar_manager.h"
 
-#include <QSettings>
+#include "fahrplan_settings.h"
 #ifndef QT_NO_CONCURRENT
     #if defined(BUILD_FOR_QT5)
     #   include <QtConcurrent/QtConcurrentRun>
@@ -39,6 +39,9 @@
 #   include <QOrganizerManager>
 #endif
 
+QList<CalendarInfo> FahrplanCalendarManager::cachedCalendars;
+bool FahrplanCalendarManager::cacheValid = false;
+
 FahrplanCalendarManager::FahrplanCalendarManager(QObject *parent)
     : QAbstractListModel(parent)
     , m_selectedIndex(0)
@@ -46,15 +49,21 @@ FahrplanCalendarManager::FahrplanCalendarManager(QObject *parent)
 #if QT_VERSION < QT_VERSION_CHECK(5,0,0)
     setRoleNames(roleNames());
 #endif
-    settings = new QSettings(FAHRPLAN_SETTINGS_NAMESPACE, "fahrplan2", this);
+    settings = FahrplanSettings::instance();
 #ifndef QT_NO_CONCURRENT
-    m_watcher = new QFutureWatcher<void>(this);
+    m_reloadPending = false;
+    m_watcher = new QFutureWatcher<QList<CalendarInfo> >(this);
     connect(m_watcher, SIGNAL(finished()), SLOT(getCalendarsListFinished()));
     connect(m_watcher, SIGNAL(started()), SIGNAL(selectedCalendarNameChanged()));
 #endif
 
     // Change of slectedIndex always changes selectedCalendarName
     connect(this, SIGNAL(selectedIndexChanged()), SIGNAL(selectedCalendarNameChanged()));
+
+    if (cacheValid) {
+        m_calendars = cachedCalendars;
+        m_selectedIndex = storedSelectedIndex();
+    }
 }
 
 QHash<int, QByteArray> FahrplanCalendarManager::roleNames() const
@@ -104,29 +113,27 @@ void FahrplanCalendarManager::setSelectedIndex(int index)
     m_selectedIndex = index;
     emit selectedIndexChanged();
 
-    settings->beginGroup("Calendar");
     if (index > 0) {
 #ifdef BUILD_FOR_BLACKBERRY
-        settings->setValue("AccountId", m_calendars.at(index).accountId);
-        settings->setValue("FolderId", m_calendars.at(index).folderId);
+        settings->setValue("Calendar/AccountId", m_calendars.at(index).accountId);
+        settings->setValue("Calendar/FolderId", m_calendars.at(index).folderId);
 #else
-        settings->setValue("CollectionId", m_calendars.at(index).collectionId);
+        settings->setValue("Calendar/CollectionId", m_calendars.at(index).collectionId);
 #endif
     } else {
 #ifdef BUILD_FOR_BLACKBERRY
-        settings->remove("AccountId");
-        settings->remove("FolderId");
+        settings->remove("Calendar/AccountId");
+        settings->remove("Calendar/FolderId");
 #else
-        settings->remove("CollectionId");
+        settings->remove("Calendar/CollectionId");
 #endif
     }
-    settings->endGroup();
 }
 
 QString FahrplanCalendarManager::selectedCalendarName() const
 {
 #ifndef QT_NO_CONCURRENT
-    if (m_watcher->isRunning())
+    if (m_calendars.isEmpty() && m_watcher->isRunning())
         return tr("<loading calendars list...>");
 #endif
     if ((m_selectedIndex < 0) || (m_selectedIndex >= m_calendars.count()))
@@ -139,36 +146,30 @@ QString FahrplanCalendarManager::selectedCalendarName() const
 
 void FahrplanCalendarManager::reload()
 {
+    // The cached list is shown meanwhile, the model is only touched again
+    // if the fetched list differs from it.
 #ifndef QT_NO_CONCURRENT
-    if (m_watcher->isRunning())
-        m_watcher->waitForFinished();
-#endif
-
-    beginResetModel();
-
-    m_calendars.clear();
-    m_calendars << CalendarInfo(tr("Default Calendar"));
-    m_selectedIndex = 0;
+    // Never wait for a running fetch, just fetch again once it is done.
+    if (m_watcher->isRunning()) {
+        m_reloadPending = true;
+        return;
+    }
 
-#ifndef QT_NO_CONCURRENT
-    // Run fetch in a separate thread.
-    QFuture<void> future = QtConcurrent::run(this, &FahrplanCalendarManager::getCalendarsList);
+    QFuture<QList<CalendarInfo> > future = QtConcurrent::run(&FahrplanCalendarManager::getCalendarsList);
     m_watcher->setFuture(future);
 #else
-    getCalendarsList();
-    getCalendarsListFinished();
+    cachedCalendars = getCalendarsList();
+    cacheValid = true;
+    setCalendars(cachedCalendars);
 #endif
-
-    // endResetModel() is called in getCalendarsListFinished() function.
 }
 
-void FahrplanCalendarManager::getCalendarsList()
+QList<CalendarInfo> FahrplanCalendarManager::getCalendarsList()
 {
-    settings->beginGroup("Calendar");
-#ifdef BUILD_FOR_BLACKBERRY
-    int accountId = settings->value("AccountId", -1).toInt();
-    int folderId = settings->value("FolderId", -1).toInt();
+    QList<CalendarInfo> calendars;
+    calendars << CalendarInfo(tr("Default Calendar"));
 
+#ifdef BUILD_FOR_BLACKBERRY
     bb::pim::calendar::CalendarService service;
     bb::pim::account::AccountService accservice;
     QList<bb::pim::calendar::CalendarFolder> folders = service.folders();
@@ -183,20 +184,13 @@ void FahrplanCalendarManager::getCalendarsList()
             account = accservice.account(folder.accountId()).displayName();
 
         //: Calendar name (Account name)
-        m_calendars << CalendarInfo(tr("%1 (%2)", "Calendar name (Account name)")
-                                    .arg(folder.name()).arg(account)
-                                    , folder.accountId(), folder.id());
-        if ((folder.id() == folderId) && (folder.accountId() == accountId)) {
-            m_selectedIndex = m_calendars.count() - 1;
-            emit selectedIndexChanged();
-        }
+        calendars << CalendarInfo(tr("%1 (%2)", "Calendar name (Account name)")
+                                  .arg(folder.name()).arg(account)
+                                  , folder.accountId(), folder.id());
     }
 #elif defined(BUILD_FOR_SAILFISHOS)
 
 #elif !defined(BUILD_FOR_DESKTOP) && !defined(BUILD_FOR_UBUNTU)
-    QString id = settings->value("CollectionId").toString();
-    QOrganizerCollectionId collectionId = QOrganizerCollectionId::fromString(id);
-
     QOrganizerManager manager;
     QList<QOrganizerCollection> collections = manager.collections();
     foreach (const QOrganizerCollection &collection, collections) {
@@ -233,12 +227,11 @@ void FahrplanCalendarManager::getCalendarsList()
                 )
             continue;
 
-        m_calendars << CalendarInfo(normalizeCalendarName(collection.metaData(QOrganizerCollection::KeyName).toString()), collection.id().toString());
-        if (collection.id() == collectionId)
-            m_selectedIndex = m_calendars.count() - 1;
+        calendars << CalendarInfo(normalizeCalendarName(collection.metaData(QOrganizerCollection::KeyName).toString()), collection.id().toString());
     }
 #endif
-    settings->endGroup();
+
+    return calendars;
 }
 
 QString FahrplanCalendarManager::normalizeCalendarName(QString name)
@@ -250,9 +243,54 @@ QString FahrplanCalendarManager::normalizeCalendarName(QString name)
     return name;
 }
 
-void FahrplanCalendarManager::getCalendarsListFinished()
+void FahrplanCalendarManager::setCalendars(const QList<CalendarInfo> &calendars)
 {
+    if (calendars == m_calendars)
+        return;
+
+    const int oldCount = m_calendars.count();
+    beginResetModel();
+    m_calendars = calendars;
+    m_selectedIndex = storedSelectedIndex();
     endResetModel();
-    emit countChanged();
+
+    if (m_calendars.count() != oldCount)
+        emit countChanged();
     emit selectedIndexChanged();
 }
+
+int FahrplanCalendarManager::storedSelectedIndex() const
+{
+#ifdef BUILD_FOR_BLACKBERRY
+    int accountId = settings->value("Calendar/AccountId", -1).toInt();
+    int folderId = settings->value("Calendar/FolderId", -1).toInt();
+    for (int i = 1; i < m_calendars.count(); ++i) {
+        if ((m_calendars.at(i).folderId == folderId) && (m_calendars.at(i).accountId == accountId))
+            return i;
+    }
+#else
+    QString collectionId = settings->value("Calendar/CollectionId").toString();
+    if (collectionId.isEmpty())
+        return 0;
+    for (int i = 1; i < m_calendars.count(); ++i) {
+        if (m_calendars.at(i).collectionId == collectionId)
+            return i;
+    }
+#endif
+    return 0;
+}
+
+void FahrplanCalendarManager::getCalendarsListFinished()
+{
+#ifndef QT_NO_CONCURRENT
+    cachedCalendars = m_watcher->result();
+    cacheValid = true;
+    setCalendars(cachedCalendars);
+    emit selectedCalendarNameChanged();
+
+    if (m_reloadPending) {
+        m_reloadPending = false;
+        reload();
+    }
+#endif
+}
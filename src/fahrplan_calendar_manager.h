@@ -36,20 +36,36 @@ struct CalendarInfo
 
     CalendarInfo(const QString &name, int accountId = -1, int folderId = -1)
         : name(name), accountId(accountId), folderId(folderId) {}
+
+    bool operator==(const CalendarInfo &other) const
+    {
+        return name == other.name && accountId == other.accountId && folderId == other.folderId;
+    }
 #else
     QString collectionId;
 
     CalendarInfo(const QString &name, const QString &collectionId = QString())
         : name(name), collectionId(collectionId) {}
+
+    bool operator==(const CalendarInfo &other) const
+    {
+        return name == other.name && collectionId == other.collectionId;
+    }
 #endif
 };
 
-class QSettings;
+class FahrplanSettings;
 #ifndef QT_NO_CONCURRENT
 template <typename T>
 class QFutureWatcher;
 #endif
 
+/**
+ * @brief List of calendars events can be added to.
+ * The list is fetched in background and kept for the whole application,
+ * so reopening settings shows it right away. Every reload() refreshes it
+ * in background again and the model is only reset if it has changed.
+ */
 class FahrplanCalendarManager: public QAbstractListModel
 {
     Q_OBJECT
@@ -78,16 +94,25 @@ signals:
     void selectedCalendarNameChanged();
 
 private:
-    QSettings *settings;
+    FahrplanSettings *settings;
 #ifndef QT_NO_CONCURRENT
-    QFutureWatcher<void> *m_watcher;
+    QFutureWatcher<QList<CalendarInfo> > *m_watcher;
+    // reload() was called while a fetch was running.
+    bool m_reloadPending;
 #endif
 
     QList<CalendarInfo> m_calendars;
     int m_selectedIndex;
 
-    void getCalendarsList();
-    QString normalizeCalendarName(QString name);
+    // Last fetched list, shared by all instances.
+    static QList<CalendarInfo> cachedCalendars;
+    static bool cacheValid;
+
+    // Runs on a worker thread, must not touch any instance.
+    static QList<CalendarInfo> getCalendarsList();
+    static QString normalizeCalendarName(QString name);
+    void setCalendars(const QList<CalendarInfo> &calendars);
+    int storedSelectedIndex() const;
 
 private slots:
     void getCalendarsListFinished();
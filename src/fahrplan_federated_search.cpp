@@ -0,0 +1,394 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "fahrplan_federated_search.h"
+#include "fahrplan_parser_pool.h"
+#include "fahrplan_parser_thread.h"
+
+#include <QTimer>
+
+FahrplanFederatedSearch::FahrplanFederatedSearch(QObject *parent)
+    : QObject(parent)
+    , m_store(new JourneyResultList(this))
+    , m_merged(NULL)
+    , m_deadline(20000)
+    , m_hadError(false)
+    , m_departureStation(Station(false))
+    , m_viaStation(Station(false))
+    , m_arrivalStation(Station(false))
+    , m_mode(ParserAbstract::Departure)
+    , m_trainrestrictions(0)
+    , m_primary(-1)
+{
+}
+
+FahrplanFederatedSearch::~FahrplanFederatedSearch()
+{
+    foreach (Backend *b, m_backends) {
+        releaseThread(b);
+        delete b;
+    }
+}
+
+QList<int> FahrplanFederatedSearch::backends() const
+{
+    return m_backendIndexes;
+}
+
+void FahrplanFederatedSearch::setBackends(const QList<int> &backends)
+{
+    m_backendIndexes = backends;
+}
+
+void FahrplanFederatedSearch::setDeadline(int msecs)
+{
+    m_deadline = msecs;
+}
+
+void FahrplanFederatedSearch::searchJourney(int primaryBackend, const Station &departureStation, const Station &viaStation, const Station &arrivalStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions)
+{
+    cancelRequest();
+    resetResults();
+
+    m_primary = primaryBackend;
+    m_departureStation = departureStation;
+    m_viaStation = viaStation;
+    m_arrivalStation = arrivalStation;
+    m_dateTime = dateTime;
+    m_mode = mode;
+    m_trainrestrictions = trainrestrictions;
+    m_hadError = false;
+
+    QList<int> wanted;
+    wanted << primaryBackend;
+    foreach (int index, m_backendIndexes) {
+        if (!wanted.contains(index))
+            wanted << index;
+    }
+
+    // Drop backends which are no longer part of the federation.
+    for (int i = m_backends.count() - 1; i >= 0; --i) {
+        if (!wanted.contains(m_backends.at(i)->index)) {
+            Backend *b = m_backends.takeAt(i);
+            releaseThread(b);
+            delete b->deadline;
+            delete b;
+        }
+    }
+
+    foreach (int index, wanted)
+        startBackend(backend(index));
+}
+
+void FahrplanFederatedSearch::searchJourneyLater()
+{
+    resetResults();
+    foreach (Backend *b, m_backends) {
+        if (!b->hasResults)
+            continue;
+        b->state = Searching;
+        b->hasResults = false;
+        b->deadline->start(m_deadline);
+        b->thread->searchJourneyLater();
+    }
+}
+
+void FahrplanFederatedSearch::searchJourneyEarlier()
+{
+    resetResults();
+    foreach (Backend *b, m_backends) {
+        if (!b->hasResults)
+            continue;
+        b->state = Searching;
+        b->hasResults = false;
+        b->deadline->start(m_deadline);
+        b->thread->searchJourneyEarlier();
+    }
+}
+
+bool FahrplanFederatedSearch::getJourneyDetails(const QString &id)
+{
+    if (!m_detailRoutes.contains(id))
+        return false;
+
+    QPair<Backend *, QString> route = m_detailRoutes.value(id);
+    route.first->thread->getJourneyDetails(route.second);
+    return true;
+}
+
+void FahrplanFederatedSearch::cancelRequest()
+{
+    foreach (Backend *b, m_backends) {
+        if (b->state == Idle || b->state == Done)
+            continue;
+        b->deadline->stop();
+        b->thread->cancelRequest();
+        b->state = Done;
+    }
+}
+
+void FahrplanFederatedSearch::clearResults()
+{
+    cancelRequest();
+    // The merged list may still be shown until the new results arrive.
+    m_detailRoutes.clear();
+    m_mergedKeys.clear();
+    foreach (Backend *b, m_backends)
+        b->hasResults = false;
+}
+
+void FahrplanFederatedSearch::onStationsResult(const StationsList &result)
+{
+    Backend *b = backendForSender();
+    if (!b)
+        return;
+
+    Station station = result.isEmpty() ? Station(false) : result.first();
+
+    switch (b->state) {
+    case ResolvingDeparture:
+        b->departureStation = station;
+        break;
+    case ResolvingVia:
+        b->viaStation = station;
+        break;
+    case ResolvingArrival:
+        b->arrivalStation = station;
+        break;
+    default:
+        return;
+    }
+
+    // A backend which does not know one of the stations can not contribute.
+    if (!station.valid) {
+        finishBackend(b);
+        return;
+    }
+
+    resolveNext(b);
+}
+
+void FahrplanFederatedSearch::onJourneyResult(JourneyResultList *result)
+{
+    Backend *b = backendForSender();
+    if (!b || b->state != Searching)
+        return;
+
+    if (result && result->itemcount() > 0) {
+        b->hasResults = true;
+        mergeResults(b, result);
+    }
+
+    finishBackend(b);
+}
+
+void FahrplanFederatedSearch::onJourneyDetailsResult(JourneyDetailResultList *result)
+{
+    emit journeyDetailsResult(result);
+}
+
+void FahrplanFederatedSearch::onErrorOccured(const QString &msg)
+{
+    Backend *b = backendForSender();
+    if (!b || b->state == Idle || b->state == Done) {
+        // Errors while loading details are always interesting.
+        emit errorOccured(msg);
+        return;
+    }
+
+    m_hadError = true;
+    m_lastError = msg;
+    finishBackend(b);
+}
+
+void FahrplanFederatedSearch::onDeadline()
+{
+    Backend *b = backendForSender();
+    if (!b || b->state == Idle || b->state == Done)
+        return;
+
+    b->thread->cancelRequest();
+    finishBackend(b);
+}
+
+FahrplanFederatedSearch::Backend *FahrplanFederatedSearch::backend(int index)
+{
+    foreach (Backend *b, m_backends) {
+        if (b->index == index)
+            return b;
+    }
+
+    Backend *b = new Backend;
+    b->index = index;
+    b->state = Idle;
+    b->hasResults = false;
+    b->departureStation = Station(false);
+    b->viaStation = Station(false);
+    b->arrivalStation = Station(false);
+
+    b->thread = FahrplanParserPool::instance()->acquire(index, this);
+    connect(b->thread, SIGNAL(stationsResult(StationsList)), SLOT(onStationsResult(StationsList)));
+    connect(b->thread, SIGNAL(journeyResult(JourneyResultList*)), SLOT(onJourneyResult(JourneyResultList*)));
+    connect(b->thread, SIGNAL(journeyDetailsResult(JourneyDetailResultList*)), SLOT(onJourneyDetailsResult(JourneyDetailResultList*)));
+    connect(b->thread, SIGNAL(errorOccured(QString)), SLOT(onErrorOccured(QString)));
+
+    b->deadline = new QTimer(this);
+    b->deadline->setSingleShot(true);
+    connect(b->deadline, SIGNAL(timeout()), SLOT(onDeadline()));
+
+    m_backends.append(b);
+    return b;
+}
+
+void FahrplanFederatedSearch::releaseThread(Backend *b)
+{
+    disconnect(b->thread, 0, this, 0);
+    FahrplanParserPool::instance()->release(b->thread, this);
+    b->thread = NULL;
+}
+
+FahrplanFederatedSearch::Backend *FahrplanFederatedSearch::backendForSender()
+{
+    QObject *s = sender();
+    foreach (Backend *b, m_backends) {
+        if (b->thread == s || b->deadline == s)
+            return b;
+    }
+    return NULL;
+}
+
+void FahrplanFederatedSearch::resetResults()
+{
+    m_detailRoutes.clear();
+    m_mergedKeys.clear();
+    if (m_merged) {
+        m_merged->deleteLater();
+        m_merged = NULL;
+    }
+    delete m_store;
+    m_store = new JourneyResultList(this);
+}
+
+void FahrplanFederatedSearch::startBackend(Backend *b)
+{
+    b->hasResults = false;
+    b->deadline->start(m_deadline);
+
+    if (b->index == m_primary) {
+        // Stations were picked in this backend, no need to look them up.
+        b->departureStation = m_departureStation;
+        b->viaStation = m_viaStation;
+        b->arrivalStation = m_arrivalStation;
+        b->state = ResolvingArrival;
+        resolveNext(b);
+        return;
+    }
+
+    b->departureStation = Station(false);
+    b->viaStation = Station(false);
+    b->arrivalStation = Station(false);
+    b->state = ResolvingDeparture;
+    b->thread->findStationsByName(m_departureStation.name);
+}
+
+void FahrplanFederatedSearch::resolveNext(Backend *b)
+{
+    if (b->state == ResolvingDeparture) {
+        if (m_viaStation.valid && b->thread->supportsVia()) {
+            b->state = ResolvingVia;
+            b->thread->findStationsByName(m_viaStation.name);
+            return;
+        }
+        b->state = ResolvingVia;
+    }
+
+    if (b->state == ResolvingVia) {
+        b->state = ResolvingArrival;
+        b->thread->findStationsByName(m_arrivalStation.name);
+        return;
+    }
+
+    // Train restrictions are backend specific, only the primary backend
+    // understands the selected one.
+    b->state = Searching;
+    b->thread->searchJourney(b->departureStation, b->viaStation, b->arrivalStation, m_dateTime, m_mode, b->index == m_primary ? m_trainrestrictions : 0);
+}
+
+void FahrplanFederatedSearch::finishBackend(Backend *b)
+{
+    b->deadline->stop();
+    b->state = Done;
+
+    foreach (Backend *other, m_backends) {
+        if (other->state != Done)
+            return;
+    }
+
+    if (m_store->itemcount() == 0 && m_hadError)
+        emit errorOccured(m_lastError);
+
+    emit finished();
+}
+
+void FahrplanFederatedSearch::mergeResults(Backend *b, JourneyResultList *result)
+{
+    for (int i = 0; i < result->itemcount(); ++i) {
+        const int row = result->row(i);
+        const QString key = mergeKey(result, row);
+        if (m_mergedKeys.contains(key))
+            continue;
+        m_mergedKeys.insert(key, b->index);
+
+        // Rows are copied, the parsers result list may be reused by it.
+        m_store->appendItem(result->getItem(i));
+        const QString id = QString("%1:%2").arg(b->index).arg(result->id(row));
+        m_store->getItem(m_store->itemcount() - 1)->setId(id);
+        m_detailRoutes.insert(id, qMakePair(b, result->id(row)));
+    }
+
+    JourneyResultList *merged = new JourneyResultList();
+    if (m_merged) {
+        merged->setDepartureStation(m_merged->departureStation());
+        merged->setViaStation(m_merged->viaStation());
+        merged->setArrivalStation(m_merged->arrivalStation());
+        merged->setTimeInfo(m_merged->timeInfo());
+        m_merged->deleteLater();
+    }
+    if (!m_merged || b->index == m_primary) {
+        merged->setDepartureStation(result->departureStation());
+        merged->setViaStation(result->viaStation());
+        merged->setArrivalStation(result->arrivalStation());
+        merged->setTimeInfo(result->timeInfo());
+    }
+    for (int i = 0; i < m_store->itemcount(); ++i)
+        merged->appendItem(m_store->getItem(i));
+    merged->setSortOrder(JourneyResultList::DepartureOrder);
+    m_merged = merged;
+
+    emit journeyResult(m_merged);
+}
+
+QString FahrplanFederatedSearch::mergeKey(JourneyResultList *list, int row) const
+{
+    QString trainType = list->trainType(row).toLower();
+    trainType.remove(' ');
+    if (list->departureStamp(row) < 0 || list->arrivalStamp(row) < 0)
+        return QString("%1|%2|%3|%4").arg(list->date(row).toString(Qt::ISODate), list->departureTime(row), list->arrivalTime(row), trainType);
+    return QString("%1|%2|%3").arg(list->departureStamp(row)).arg(list->arrivalStamp(row)).arg(trainType);
+}
@@ -0,0 +1,122 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef FAHRPLAN_FEDERATED_SEARCH_H
+#define FAHRPLAN_FEDERATED_SEARCH_H
+
+#include "parser/parser_abstract.h"
+
+#include <QHash>
+#include <QPair>
+
+class FahrplanParserThread;
+class QTimer;
+
+/**
+ * @brief Runs one journey search on several backends at once.
+ * Every backend gets a parser thread of the pool and its own deadline. Stations
+ * are only valid for the backend they were selected in, so the other
+ * backends first resolve them by name. Results are merged, deduplicated by
+ * departure, arrival and line, and emitted again whenever a backend answers.
+ */
+class FahrplanFederatedSearch : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit FahrplanFederatedSearch(QObject *parent = 0);
+        ~FahrplanFederatedSearch();
+
+        QList<int> backends() const;
+        void setBackends(const QList<int> &backends);
+        void setDeadline(int msecs);
+
+        void searchJourney(int primaryBackend, const Station &departureStation, const Station &viaStation, const Station &arrivalStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions);
+        void searchJourneyLater();
+        void searchJourneyEarlier();
+        bool getJourneyDetails(const QString &id);
+        void cancelRequest();
+        // Forgets the routes of the last search, once a search runs without
+        // federation.
+        void clearResults();
+
+    signals:
+        void journeyResult(JourneyResultList *result);
+        void journeyDetailsResult(JourneyDetailResultList *result);
+        void errorOccured(const QString &msg);
+        void finished();
+
+    private slots:
+        void onStationsResult(const StationsList &result);
+        void onJourneyResult(JourneyResultList *result);
+        void onJourneyDetailsResult(JourneyDetailResultList *result);
+        void onErrorOccured(const QString &msg);
+        void onDeadline();
+
+    private:
+        enum BackendState {
+            Idle,
+            ResolvingDeparture,
+            ResolvingVia,
+            ResolvingArrival,
+            Searching,
+            Done
+        };
+
+        struct Backend {
+            int index;
+            FahrplanParserThread *thread;
+            QTimer *deadline;
+            BackendState state;
+            bool hasResults;
+            Station departureStation;
+            Station viaStation;
+            Station arrivalStation;
+        };
+
+        QList<int> m_backendIndexes;
+        QList<Backend *> m_backends;
+        QHash<QString, QPair<Backend *, QString> > m_detailRoutes;
+        QHash<QString, int> m_mergedKeys;
+        JourneyResultList *m_store;
+        JourneyResultList *m_merged;
+        int m_deadline;
+        bool m_hadError;
+        QString m_lastError;
+
+        Station m_departureStation;
+        Station m_viaStation;
+        Station m_arrivalStation;
+        QDateTime m_dateTime;
+        ParserAbstract::Mode m_mode;
+        int m_trainrestrictions;
+        int m_primary;
+
+        Backend *backend(int index);
+        Backend *backendForSender();
+        void releaseThread(Backend *backend);
+        void resetResults();
+        void startBackend(Backend *backend);
+        void resolveNext(Backend *backend);
+        void finishBackend(Backend *backend);
+        void mergeResults(Backend *backend, JourneyResultList *result);
+        QString mergeKey(JourneyResultList *list, int row) const;
+};
+
+#endif // FAHRPLAN_FEDERATED_SEARCH_H
@@ -0,0 +1,144 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "fahrplan_parser_pool.h"
+#include "fahrplan_parser_thread.h"
+
+#include <QCoreApplication>
+
+// Idle parser threads kept running, per process.
+static const int DEFAULT_MAX_IDLE = 2;
+
+FahrplanParserPool *FahrplanParserPool::instance()
+{
+    static FahrplanParserPool *pool = NULL;
+    if (!pool)
+        pool = new FahrplanParserPool();
+    return pool;
+}
+
+FahrplanParserPool::FahrplanParserPool(QObject *parent)
+    : QObject(parent)
+    , m_maxIdle(DEFAULT_MAX_IDLE)
+    , m_stopped(false)
+{
+    if (QCoreApplication::instance())
+        connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), SLOT(shutdown()));
+}
+
+FahrplanParserThread *FahrplanParserPool::acquire(int index, const QObject *owner)
+{
+    int found = -1;
+    for (int i = 0; i < m_idle.count(); ++i) {
+        if (m_idle.at(i).index != index)
+            continue;
+        if (found < 0)
+            found = i;
+        if (owner && m_idle.at(i).owner == owner) {
+            found = i;
+            break;
+        }
+    }
+
+    FahrplanParserThread *parser;
+    if (found >= 0) {
+        parser = m_idle.takeAt(found).parser;
+    } else {
+        // Forget trimmed threads which have been autodeleted meanwhile.
+        for (int i = m_threads.count() - 1; i >= 0; --i) {
+            if (!m_threads.at(i))
+                m_threads.removeAt(i);
+        }
+
+        parser = new FahrplanParserThread();
+        parser->init(index);
+        m_threads.append(parser);
+    }
+    m_busy.insert(parser);
+    return parser;
+}
+
+void FahrplanParserPool::release(FahrplanParserThread *parser, const QObject *owner)
+{
+    if (!parser)
+        return;
+
+    m_busy.remove(parser);
+    if (m_stopped) {
+        // Already finished, nothing runs in it anymore.
+        delete parser;
+        return;
+    }
+
+    parser->cancelRequest();
+
+    IdleParser idle;
+    idle.index = parser->parserIndex();
+    idle.parser = parser;
+    idle.owner = owner;
+    m_idle.prepend(idle);
+    trim();
+}
+
+int FahrplanParserPool::maxIdle() const
+{
+    return m_maxIdle;
+}
+
+void FahrplanParserPool::setMaxIdle(int count)
+{
+    m_maxIdle = qMax(0, count);
+    trim();
+}
+
+void FahrplanParserPool::trim()
+{
+    while (m_idle.count() > m_maxIdle) {
+        // Parser object will be autodeleted after the thread quits.
+        m_idle.takeLast().parser->quit();
+    }
+}
+
+void FahrplanParserPool::shutdown()
+{
+    if (m_stopped)
+        return;
+    m_stopped = true;
+
+    // No event loop runs anymore to autodelete them, threads in use are
+    // deleted once their owners release them.
+    foreach (FahrplanParserThread *parser, m_threads) {
+        if (!parser)
+            continue;
+        disconnect(parser, SIGNAL(finished()), parser, SLOT(deleteLater()));
+        parser->quit();
+    }
+
+    foreach (FahrplanParserThread *parser, m_threads) {
+        if (!parser)
+            continue;
+        parser->wait();
+        if (!m_busy.contains(parser))
+            delete parser;
+    }
+
+    m_idle.clear();
+    m_threads.clear();
+}
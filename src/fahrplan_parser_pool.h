@@ -0,0 +1,81 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef FAHRPLAN_PARSER_POOL_H
+#define FAHRPLAN_PARSER_POOL_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QSet>
+
+class FahrplanParserThread;
+
+/**
+ * @brief Parser threads shared by all sessions of the process.
+ * A thread is used by one owner at a time, results are broadcast to
+ * whoever is connected. Released threads keep running for a while, so the
+ * next owner of the backend gets warm connections and caches. All threads
+ * are stopped when the application is about to quit. Only to be used from
+ * the main thread.
+ */
+class FahrplanParserPool : public QObject
+{
+    Q_OBJECT
+
+    public:
+        static FahrplanParserPool *instance();
+
+        // Prefers the idle thread owner released last for this backend, so
+        // switching back keeps its paging context.
+        FahrplanParserThread *acquire(int index, const QObject *owner = 0);
+        // The owner has to disconnect from the thread before, its running
+        // request is cancelled. After shutdown the thread is deleted.
+        void release(FahrplanParserThread *parser, const QObject *owner = 0);
+
+        int maxIdle() const;
+        void setMaxIdle(int count);
+
+    private slots:
+        void shutdown();
+
+    private:
+        explicit FahrplanParserPool(QObject *parent = 0);
+
+        struct IdleParser {
+            int index;
+            FahrplanParserThread *parser;
+            // Only compared, never dereferenced
+            const QObject *owner;
+        };
+
+        // Most recently released first
+        QList<IdleParser> m_idle;
+        // Acquired and not released yet
+        QSet<FahrplanParserThread *> m_busy;
+        // Every thread created, trimmed ones until they have finished
+        QList<QPointer<FahrplanParserThread> > m_threads;
+        int m_maxIdle;
+        bool m_stopped;
+
+        void trim();
+};
+
+#endif // FAHRPLAN_PARSER_POOL_H
@@ -0,0 +1,159 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "fahrplan_parser_reply.h"
+#include "fahrplan_parser_thread.h"
+
+#include <QEventLoop>
+#include <QTimer>
+#include <QTimerEvent>
+
+FahrplanParserReply::FahrplanParserReply(Type type, QObject *parent)
+    : QObject(parent)
+    , m_type(type)
+    , m_finished(false)
+    , m_error(false)
+    , m_pendingParts(0)
+    , m_deadlineTimer(0)
+    , m_thread(NULL)
+    , m_journeyResult(NULL)
+    , m_journeyDetailsResult(NULL)
+{
+}
+
+FahrplanParserReply::~FahrplanParserReply()
+{
+    FahrplanParserThread::dropReply(this);
+}
+
+FahrplanParserReply *FahrplanParserReply::all(const QList<FahrplanParserReply *> &replies, QObject *parent)
+{
+    FahrplanParserReply *group = new FahrplanParserReply(Group, parent);
+    foreach (FahrplanParserReply *reply, replies) {
+        if (!reply->isFinished()) {
+            ++group->m_pendingParts;
+            connect(reply, SIGNAL(finished()), group, SLOT(partFinished()));
+        } else if (reply->hasError() && !group->m_error) {
+            group->m_error = true;
+            group->m_errorString = reply->errorString();
+        }
+    }
+
+    // Finish asynchronously, like every other reply.
+    if (group->m_pendingParts == 0)
+        QMetaObject::invokeMethod(group, "finish", Qt::QueuedConnection);
+
+    return group;
+}
+
+FahrplanParserReply::Type FahrplanParserReply::type() const
+{
+    return m_type;
+}
+
+bool FahrplanParserReply::isFinished() const
+{
+    return m_finished;
+}
+
+bool FahrplanParserReply::hasError() const
+{
+    return m_error;
+}
+
+QString FahrplanParserReply::errorString() const
+{
+    return m_errorString;
+}
+
+StationsList FahrplanParserReply::stations() const
+{
+    return m_stations;
+}
+
+TimetableEntriesList FahrplanParserReply::timeTable() const
+{
+    return m_timeTable;
+}
+
+JourneyResultList *FahrplanParserReply::journeyResult() const
+{
+    return m_journeyResult;
+}
+
+JourneyDetailResultList *FahrplanParserReply::journeyDetailsResult() const
+{
+    return m_journeyDetailsResult;
+}
+
+bool FahrplanParserReply::waitForFinished(int msecs)
+{
+    if (m_finished)
+        return true;
+
+    QEventLoop loop;
+    connect(this, SIGNAL(finished()), &loop, SLOT(quit()));
+    if (msecs >= 0)
+        QTimer::singleShot(msecs, &loop, SLOT(quit()));
+    loop.exec();
+
+    return m_finished;
+}
+
+void FahrplanParserReply::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != m_deadlineTimer) {
+        QObject::timerEvent(event);
+        return;
+    }
+
+    killTimer(m_deadlineTimer);
+    m_deadlineTimer = 0;
+    FahrplanParserThread::expireReply(this);
+}
+
+void FahrplanParserReply::finish()
+{
+    if (m_deadlineTimer) {
+        killTimer(m_deadlineTimer);
+        m_deadlineTimer = 0;
+    }
+
+    m_finished = true;
+    emit finished();
+}
+
+void FahrplanParserReply::startDeadline(int msecs)
+{
+    if (!m_finished && !m_deadlineTimer)
+        m_deadlineTimer = startTimer(msecs);
+}
+
+void FahrplanParserReply::partFinished()
+{
+    FahrplanParserReply *reply = qobject_cast<FahrplanParserReply *>(sender());
+    if (reply && reply->hasError() && !m_error) {
+        m_error = true;
+        m_errorString = reply->errorString();
+    }
+
+    if (--m_pendingParts == 0)
+        finish();
+}
@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef FAHRPLAN_PARSER_REPLY_H
+#define FAHRPLAN_PARSER_REPLY_H
+
+#include "parser/parser_abstract.h"
+
+class FahrplanParserThread;
+
+/**
+ * @brief Result of one request made through FahrplanParserThread::query*().
+ * Finishes with the result of exactly the request it was returned for,
+ * unlike the broadcast signals of the thread. Replies are owned by the
+ * caller, deleting one which has not finished yet drops its request.
+ * Result lists are owned by the parser, like the ones of the signals.
+ */
+class FahrplanParserReply : public QObject
+{
+    Q_OBJECT
+
+    public:
+        enum Type {
+            Stations,
+            Journey,
+            JourneyDetails,
+            TimeTable,
+            // Created by all()
+            Group
+        };
+
+        ~FahrplanParserReply();
+
+        // Finishes once all replies have finished, with the error of the
+        // first one that failed, if any.
+        static FahrplanParserReply *all(const QList<FahrplanParserReply *> &replies, QObject *parent = 0);
+
+        Type type() const;
+        bool isFinished() const;
+        bool hasError() const;
+        QString errorString() const;
+
+        StationsList stations() const;
+        TimetableEntriesList timeTable() const;
+        JourneyResultList *journeyResult() const;
+        JourneyDetailResultList *journeyDetailsResult() const;
+
+        // Runs an event loop until the reply finished or msecs passed, may
+        // not be called from the parser thread itself.
+        bool waitForFinished(int msecs = -1);
+
+    signals:
+        void finished();
+
+    protected:
+        void timerEvent(QTimerEvent *event);
+
+    private slots:
+        void finish();
+        void partFinished();
+        // Started once the query runs, see FahrplanParserThread::setQueryTimeout().
+        void startDeadline(int msecs);
+
+    private:
+        friend class FahrplanParserThread;
+
+        explicit FahrplanParserReply(Type type, QObject *parent = 0);
+
+        Type m_type;
+        bool m_finished;
+        bool m_error;
+        QString m_errorString;
+        int m_pendingParts;
+        int m_deadlineTimer;
+
+        // Guarded by FahrplanParserThread's reply lock, cleared once the
+        // reply left the thread's queue.
+        FahrplanParserThread *m_thread;
+
+        ParserAbstract::Request m_request;
+
+        StationsList m_stations;
+        TimetableEntriesList m_timeTable;
+        JourneyResultList *m_journeyResult;
+        JourneyDetailResultList *m_journeyDetailsResult;
+};
+
+#endif // FAHRPLAN_PARSER_REPLY_H
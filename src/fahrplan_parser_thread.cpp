@@ -18,64 +18,206 @@
 ****************************************************************************/
 
 #include "fahrplan_parser_thread.h"
+#include "parser/parser_registry.h"
+
+#include <QMutex>
+
+Q_GLOBAL_STATIC(QMutex, replyLock)
 
 FahrplanParserThread::FahrplanParserThread(QObject *parent) :
-    QThread(parent), m_ready(false)
+    QThread(parent), m_parser(NULL), m_replyRunning(false), m_replyGeneration(0), m_queryTimeout(60000)
 {
     i_parser = -1;
 }
 
 void FahrplanParserThread::init(int parserIndex)
 {
-    if (this->isRunning()) {
+    if (i_parser >= 0) {
         return;
     }
     i_parser = parserIndex;
+
+    // The capabilities are known from the registry, the parser and its
+    // network access manager are only created by the thread itself.
+    const ParserInfo &info = ParserRegistry::info(i_parser);
+    m_name = info.name();
+    m_short_name = info.shortName();
+    m_uid = QString::fromLatin1(info.uid);
+    m_trainrestrictions = info.trainRestrictions();
+    m_supports_gps = info.supportsGps();
+    m_supports_via = info.supportsVia();
+    m_supports_timetable = info.supportsTimeTable();
+    m_supports_timetabledirection = info.supportsTimeTableDirection();
+
+    qRegisterMetaType<ParserAbstract::Mode>("ParserAbstract::Mode");
+
+    // Autodelete after thread finishes.
+    connect(this, SIGNAL(finished()), SLOT(deleteLater()));
+
     start();
-    while(!m_ready) msleep(50);
 }
 
 
 void FahrplanParserThread::getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions)
 {
-    emit requestGetTimeTableForStation(currentStation, directionStation, dateTime, mode, trainrestrictions);
+    ParserAbstract::Request request;
+    request.state = FahrplanNS::getTimeTableForStationRequest;
+    request.first = currentStation;
+    request.second = directionStation;
+    request.dateTime = dateTime;
+    request.mode = mode;
+    request.trainrestrictions = trainrestrictions;
+    queueRequest(request);
 }
 
 void FahrplanParserThread::findStationsByName(const QString &stationName)
 {
-    emit requestFindStationsByName(stationName);
+    ParserAbstract::Request request;
+    request.state = FahrplanNS::stationsByNameRequest;
+    request.text = stationName;
+    queueRequest(request);
 }
 
 void FahrplanParserThread::findStationsByCoordinates(qreal longitude, qreal latitude)
 {
-    emit requestFindStationsByCoordinates(longitude, latitude);
+    ParserAbstract::Request request;
+    request.state = FahrplanNS::stationsByCoordinatesRequest;
+    request.longitude = longitude;
+    request.latitude = latitude;
+    queueRequest(request);
 }
 
 void FahrplanParserThread::searchJourney(const Station &departureStation, const Station &viaStation, const Station &arrivalStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions)
 {
-    emit requestSearchJourney(departureStation, viaStation, arrivalStation, dateTime, mode, trainrestrictions);
+    ParserAbstract::Request request;
+    request.state = FahrplanNS::searchJourneyRequest;
+    request.first = departureStation;
+    request.second = viaStation;
+    request.third = arrivalStation;
+    request.dateTime = dateTime;
+    request.mode = mode;
+    request.trainrestrictions = trainrestrictions;
+    queueRequest(request);
 }
 
 void FahrplanParserThread::searchJourneyLater()
 {
-    emit requestSearchJourneyLater();
+    ParserAbstract::Request request;
+    request.state = FahrplanNS::searchJourneyLaterRequest;
+    queueRequest(request);
 }
 
 void FahrplanParserThread::searchJourneyEarlier()
 {
-    emit requestSearchJourneyEarlier();
+    ParserAbstract::Request request;
+    request.state = FahrplanNS::searchJourneyEarlierRequest;
+    queueRequest(request);
 }
 
 void FahrplanParserThread::getJourneyDetails(const QString &id)
 {
-    emit requestGetJourneyDetails(id);
+    ParserAbstract::Request request;
+    request.state = FahrplanNS::journeyDetailsRequest;
+    request.text = id;
+    queueRequest(request);
 }
 
 void FahrplanParserThread::cancelRequest()
 {
+    // Mark the request as cancelled right away, a running parse stops and
+    // its results are dropped. Requests made before the parser was up are
+    // simply forgotten.
+    {
+        QMutexLocker locker(replyLock());
+        if (m_parser)
+            m_parser->cancel();
+        m_pendingRequests.clear();
+    }
+    failReplies("Cancelled");
     emit requestCancelRequest();
 }
 
+FahrplanParserReply *FahrplanParserThread::queryStationsByName(const QString &stationName)
+{
+    FahrplanParserReply *reply = new FahrplanParserReply(FahrplanParserReply::Stations);
+    reply->m_request.state = FahrplanNS::stationsByNameRequest;
+    reply->m_request.text = stationName;
+    return enqueueReply(reply);
+}
+
+FahrplanParserReply *FahrplanParserThread::queryStationsByCoordinates(qreal longitude, qreal latitude)
+{
+    FahrplanParserReply *reply = new FahrplanParserReply(FahrplanParserReply::Stations);
+    if (!m_supports_gps)
+        return failedReply(reply, "The backend does not support searching by coordinates");
+
+    reply->m_request.state = FahrplanNS::stationsByCoordinatesRequest;
+    reply->m_request.longitude = longitude;
+    reply->m_request.latitude = latitude;
+    return enqueueReply(reply);
+}
+
+FahrplanParserReply *FahrplanParserThread::queryTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions)
+{
+    FahrplanParserReply *reply = new FahrplanParserReply(FahrplanParserReply::TimeTable);
+    if (!m_supports_timetable)
+        return failedReply(reply, "The backend does not support station boards");
+    if (directionStation.valid && !m_supports_timetabledirection)
+        return failedReply(reply, "The backend does not support a direction for station boards");
+
+    reply->m_request.state = FahrplanNS::getTimeTableForStationRequest;
+    reply->m_request.first = currentStation;
+    reply->m_request.second = directionStation;
+    reply->m_request.dateTime = dateTime;
+    reply->m_request.mode = mode;
+    reply->m_request.trainrestrictions = trainrestrictions;
+    return enqueueReply(reply);
+}
+
+FahrplanParserReply *FahrplanParserThread::queryJourney(const Station &departureStation, const Station &viaStation, const Station &arrivalStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions)
+{
+    FahrplanParserReply *reply = new FahrplanParserReply(FahrplanParserReply::Journey);
+    if (viaStation.valid && !m_supports_via)
+        return failedReply(reply, "The backend does not support via stations");
+
+    reply->m_request.state = FahrplanNS::searchJourneyRequest;
+    reply->m_request.first = departureStation;
+    reply->m_request.second = viaStation;
+    reply->m_request.third = arrivalStation;
+    reply->m_request.dateTime = dateTime;
+    reply->m_request.mode = mode;
+    reply->m_request.trainrestrictions = trainrestrictions;
+    return enqueueReply(reply);
+}
+
+FahrplanParserReply *FahrplanParserThread::queryJourneyLater()
+{
+    FahrplanParserReply *reply = new FahrplanParserReply(FahrplanParserReply::Journey);
+    reply->m_request.state = FahrplanNS::searchJourneyLaterRequest;
+    return enqueueReply(reply);
+}
+
+FahrplanParserReply *FahrplanParserThread::queryJourneyEarlier()
+{
+    FahrplanParserReply *reply = new FahrplanParserReply(FahrplanParserReply::Journey);
+    reply->m_request.state = FahrplanNS::searchJourneyEarlierRequest;
+    return enqueueReply(reply);
+}
+
+FahrplanParserReply *FahrplanParserThread::queryJourneyDetails(const QString &id)
+{
+    FahrplanParserReply *reply = new FahrplanParserReply(FahrplanParserReply::JourneyDetails);
+    reply->m_request.state = FahrplanNS::journeyDetailsRequest;
+    reply->m_request.text = id;
+    return enqueueReply(reply);
+}
+
+void FahrplanParserThread::setQueryTimeout(int msecs)
+{
+    QMutexLocker locker(replyLock());
+    m_queryTimeout = msecs;
+}
+
 QString FahrplanParserThread::name() {
     return m_name;
 }
@@ -89,6 +231,11 @@ QString FahrplanParserThread::uid() const
     return m_uid;
 }
 
+int FahrplanParserThread::parserIndex() const
+{
+    return i_parser;
+}
+
 bool FahrplanParserThread::supportsGps()
 {
     return m_supports_gps;
@@ -110,92 +257,270 @@ QStringList FahrplanParserThread::getTrainRestrictions()
     return m_trainrestrictions;
 }
 
-void FahrplanParserThread::run()
+void FahrplanParserThread::parserStationsResult(const StationsList &result)
 {
-    ParserAbstract *m_parser;
-
-    switch (i_parser) {
-        default:
-        case 0:
-            m_parser = new ParserMobileBahnDe();
-            break;
-        case 1:
-            m_parser = new ParserXmlOebbAt();
-            break;
-        case 2:
-            m_parser = new ParserXmlRejseplanenDk();
-            break;
-        case 3:
-            m_parser = new ParserXmlSbbCh();
-            break;
-        case 4:
-            m_parser = new ParserXmlNri();
-            break;
-        case 5:
-            m_parser = new ParserXmlVasttrafikSe();
-            break;
-        case 6:
-            m_parser = new ParserPTVVicGovAu();
-            break;
-        case 7:
-            m_parser = new ParserSydneyEFA();
-            break;
-        case 8:
-            m_parser = new ParserSFBayEFA();
-            break;
-        case 9:
-            m_parser = new ParserIrelandEFA();
-            break;
-        case 10:
-            m_parser = new ParserDubaiEFA();
-            break;
-        case 11:
-            m_parser = new ParserNinetwo();
-            break;
-        case 12:
-            m_parser = new ParserMunichEFA();
-            break;
-        case 13:
-            m_parser = new ParserSalzburgEFA();
-            break;
-        case 14:
-            m_parser = new ParserResRobot();
-            break;
+    StationsList stations = result;
+    m_parser->stringPool()->intern(stations);
+
+    QMutexLocker locker(replyLock());
+    if (m_parser->isCancelled())
+        return;
+    if (m_replyRunning) {
+        if (isReplyResult(FahrplanParserReply::Stations)) {
+            FahrplanParserReply *reply = m_replies.takeFirst();
+            if (reply)
+                reply->m_stations = stations;
+            finishRunningReply(reply);
+        }
+        return;
     }
+    locker.unlock();
 
-    m_name = m_parser->name();
-    m_short_name = m_parser->shortName();
-    m_uid = m_parser->uid();
-    m_trainrestrictions = m_parser->getTrainRestrictions();
-    m_supports_gps = m_parser->supportsGps();
-    m_supports_via = m_parser->supportsVia();
-    m_supports_timetable = m_parser->supportsTimeTable();
-    m_supports_timetabledirection = m_parser->supportsTimeTableDirection();
+    emit stationsResult(stations);
+}
 
-    qRegisterMetaType<ParserAbstract::Mode>("ParserAbstract::Mode");
-    //Connect thread requests with actual parser
-    connect(this, SIGNAL(requestCancelRequest()), m_parser, SLOT(cancelRequest()), Qt::QueuedConnection);
-    connect(this, SIGNAL(requestFindStationsByName(QString)), m_parser, SLOT(findStationsByName(QString)), Qt::QueuedConnection);
-    connect(this, SIGNAL(requestFindStationsByCoordinates(qreal,qreal)), m_parser, SLOT(findStationsByCoordinates(qreal,qreal)), Qt::QueuedConnection);
-    connect(this, SIGNAL(requestGetJourneyDetails(QString)), m_parser, SLOT(getJourneyDetails(QString)), Qt::QueuedConnection);
-    connect(this, SIGNAL(requestGetTimeTableForStation(Station,Station,QDateTime,ParserAbstract::Mode,int)), m_parser, SLOT(getTimeTableForStation(Station,Station,QDateTime,ParserAbstract::Mode,int)), Qt::QueuedConnection);
-    connect(this, SIGNAL(requestSearchJourney(Station,Station,Station,QDateTime,ParserAbstract::Mode,int)), m_parser, SLOT(searchJourney(Station,Station,Station,QDateTime,ParserAbstract::Mode,int)), Qt::QueuedConnection);
-    connect(this, SIGNAL(requestSearchJourneyEarlier()), m_parser, SLOT(searchJourneyEarlier()), Qt::QueuedConnection);
-    connect(this, SIGNAL(requestSearchJourneyLater()), m_parser, SLOT(searchJourneyLater()), Qt::QueuedConnection);
+void FahrplanParserThread::parserJourneyResult(JourneyResultList *result)
+{
+    QMutexLocker locker(replyLock());
+    if (m_parser->isCancelled())
+        return;
+    if (m_replyRunning) {
+        if (isReplyResult(FahrplanParserReply::Journey)) {
+            FahrplanParserReply *reply = m_replies.takeFirst();
+            if (reply)
+                reply->m_journeyResult = result;
+            finishRunningReply(reply);
+        }
+        return;
+    }
+    locker.unlock();
 
-    //Connect parser responses with threads corresponding results
-    connect(m_parser, SIGNAL(errorOccured(QString)), this, SIGNAL(errorOccured(QString)), Qt::QueuedConnection);
-    connect(m_parser, SIGNAL(journeyDetailsResult(JourneyDetailResultList*)), this, SIGNAL(journeyDetailsResult(JourneyDetailResultList*)), Qt::QueuedConnection);
-    connect(m_parser, SIGNAL(journeyResult(JourneyResultList*)), this, SIGNAL(journeyResult(JourneyResultList*)), Qt::QueuedConnection);
-    connect(m_parser, SIGNAL(stationsResult(StationsList)), this, SIGNAL(stationsResult(StationsList)), Qt::QueuedConnection);
-    connect(m_parser, SIGNAL(timetableResult(TimetableEntriesList)), this, SIGNAL(timeTableResult(TimetableEntriesList)), Qt::QueuedConnection);
+    emit journeyResult(result);
+}
+
+void FahrplanParserThread::parserJourneyDetailsResult(JourneyDetailResultList *result)
+{
+    QMutexLocker locker(replyLock());
+    if (m_parser->isCancelled())
+        return;
+    if (m_replyRunning) {
+        if (isReplyResult(FahrplanParserReply::JourneyDetails)) {
+            FahrplanParserReply *reply = m_replies.takeFirst();
+            if (reply)
+                reply->m_journeyDetailsResult = result;
+            finishRunningReply(reply);
+        }
+        return;
+    }
+    locker.unlock();
 
-    m_ready = true;
+    emit journeyDetailsResult(result);
+}
 
-    // Autodelete after thread finishes.
-    connect(this, SIGNAL(finished()), SLOT(deleteLater()));
+void FahrplanParserThread::parserTimetableResult(const TimetableEntriesList &result)
+{
+    TimetableEntriesList entries = result;
+    m_parser->stringPool()->intern(entries);
+
+    QMutexLocker locker(replyLock());
+    if (m_parser->isCancelled())
+        return;
+    if (m_replyRunning) {
+        if (isReplyResult(FahrplanParserReply::TimeTable)) {
+            FahrplanParserReply *reply = m_replies.takeFirst();
+            if (reply)
+                reply->m_timeTable = entries;
+            finishRunningReply(reply);
+        }
+        return;
+    }
+    locker.unlock();
+
+    emit timeTableResult(entries);
+}
+
+void FahrplanParserThread::parserErrorOccured(QString msg)
+{
+    QMutexLocker locker(replyLock());
+    if (m_parser->isCancelled())
+        return;
+    if (m_replyRunning) {
+        if (m_parser->generation() == m_replyGeneration) {
+            FahrplanParserReply *reply = m_replies.takeFirst();
+            if (reply) {
+                reply->m_error = true;
+                reply->m_errorString = msg;
+            }
+            finishRunningReply(reply);
+        }
+        return;
+    }
+    locker.unlock();
+
+    emit errorOccured(msg);
+}
+
+void FahrplanParserThread::run()
+{
+    ParserAbstract *parser = ParserRegistry::create(i_parser);
+
+    //Connect thread requests with actual parser, which handles them on a
+    //parse worker
+    connect(this, SIGNAL(requestCancelRequest()), parser, SLOT(cancelRequest()), Qt::QueuedConnection);
+    connect(this, SIGNAL(requestQueued(ParserAbstract::Request)), parser, SLOT(queueRequest(ParserAbstract::Request)), Qt::QueuedConnection);
+
+    //Connect parser responses with threads corresponding results
+    connect(parser, SIGNAL(errorOccured(QString)), this, SLOT(parserErrorOccured(QString)), Qt::DirectConnection);
+    connect(parser, SIGNAL(journeyDetailsResult(JourneyDetailResultList*)), this, SLOT(parserJourneyDetailsResult(JourneyDetailResultList*)), Qt::DirectConnection);
+    connect(parser, SIGNAL(journeyResult(JourneyResultList*)), this, SLOT(parserJourneyResult(JourneyResultList*)), Qt::DirectConnection);
+    connect(parser, SIGNAL(stationsResult(StationsList)), this, SLOT(parserStationsResult(StationsList)), Qt::DirectConnection);
+    connect(parser, SIGNAL(timetableResult(TimetableEntriesList)), this, SLOT(parserTimetableResult(TimetableEntriesList)), Qt::DirectConnection);
+
+    {
+        QMutexLocker locker(replyLock());
+        m_parser = parser;
+        foreach (const ParserAbstract::Request &request, m_pendingRequests)
+            emit requestQueued(request);
+        m_pendingRequests.clear();
+    }
 
     exec();
 
-    delete m_parser;
+    failReplies("The parser has stopped");
+
+    parser->waitForParsing();
+    {
+        QMutexLocker locker(replyLock());
+        m_parser = NULL;
+    }
+    delete parser;
+}
+
+void FahrplanParserThread::queueRequest(const ParserAbstract::Request &request)
+{
+    failReplies("Superseded by another request");
+
+    QMutexLocker locker(replyLock());
+    sendRequest(request);
+}
+
+FahrplanParserReply *FahrplanParserThread::enqueueReply(FahrplanParserReply *reply)
+{
+    QMutexLocker locker(replyLock());
+    reply->m_thread = this;
+    m_replies.append(reply);
+    startNextReply();
+    return reply;
+}
+
+FahrplanParserReply *FahrplanParserThread::failedReply(FahrplanParserReply *reply, const QString &error)
+{
+    reply->m_error = true;
+    reply->m_errorString = error;
+    QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+    return reply;
+}
+
+void FahrplanParserThread::failReplies(const QString &error)
+{
+    QMutexLocker locker(replyLock());
+    foreach (FahrplanParserReply *reply, m_replies) {
+        if (!reply)
+            continue;
+        reply->m_error = true;
+        reply->m_errorString = error;
+        reply->m_thread = NULL;
+        QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+    }
+
+    // A late result of the running query must not be taken for the one of
+    // the request that replaced it.
+    if (m_replyRunning && m_parser)
+        m_parser->cancel();
+    m_replies.clear();
+    m_replyRunning = false;
+}
+
+void FahrplanParserThread::dropReply(FahrplanParserReply *reply)
+{
+    QMutexLocker locker(replyLock());
+    FahrplanParserThread *thread = reply->m_thread;
+    if (!thread)
+        return;
+
+    const int index = thread->m_replies.indexOf(reply);
+    if (index == 0 && thread->m_replyRunning)
+        thread->m_replies[0] = NULL;
+    else if (index >= 0)
+        thread->m_replies.removeAt(index);
+}
+
+void FahrplanParserThread::expireReply(FahrplanParserReply *reply)
+{
+    QMutexLocker locker(replyLock());
+    FahrplanParserThread *thread = reply->m_thread;
+    if (!thread || !thread->m_replyRunning || thread->m_replies.first() != reply)
+        return;
+
+    // A late result of the expired request is dropped, the next query
+    // starts right away.
+    if (thread->m_parser)
+        thread->m_parser->cancel();
+    else
+        thread->m_pendingRequests.clear();
+    thread->m_replies.removeFirst();
+    reply->m_error = true;
+    reply->m_errorString = "Timeout";
+    thread->finishRunningReply(reply);
+}
+
+// The following expect replyLock() to be held.
+
+void FahrplanParserThread::startNextReply()
+{
+    if (m_replyRunning || m_replies.isEmpty())
+        return;
+
+    // A request made through the slots which is still running must
+    // neither answer the query nor keep the parser busy. Anything queued
+    // from now on belongs to the query.
+    if (m_parser) {
+        m_replyGeneration = m_parser->cancel();
+    } else {
+        // A new parser starts at generation 0.
+        m_pendingRequests.clear();
+        m_replyGeneration = 0;
+    }
+
+    m_replyRunning = true;
+    FahrplanParserReply *reply = m_replies.first();
+    sendRequest(reply->m_request);
+    if (m_queryTimeout > 0)
+        QMetaObject::invokeMethod(reply, "startDeadline", Qt::QueuedConnection, Q_ARG(int, m_queryTimeout));
+}
+
+void FahrplanParserThread::sendRequest(const ParserAbstract::Request &request)
+{
+    if (m_parser)
+        emit requestQueued(request);
+    else
+        m_pendingRequests.append(request);
+}
+
+bool FahrplanParserThread::isReplyResult(FahrplanParserReply::Type type) const
+{
+    // Only jobs of the query's generation answer it, results of another
+    // type are dropped. A dropped query still takes its result.
+    return m_parser->generation() == m_replyGeneration
+            && (!m_replies.first() || m_replies.first()->type() == type);
+}
+
+void FahrplanParserThread::finishRunningReply(FahrplanParserReply *reply)
+{
+    if (reply) {
+        reply->m_thread = NULL;
+        QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+    }
+    m_replyRunning = false;
+    startNextReply();
 }
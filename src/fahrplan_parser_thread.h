@@ -21,24 +21,8 @@
 #define FAHRPLAN_PARSER_THREAD_H
 
 #include <QThread>
+#include "fahrplan_parser_reply.h"
 #include "parser/parser_abstract.h"
-#include "parser/parser_hafasxml.h"
-#include "parser/parser_hafasbinary.h"
-#include "parser/parser_xmloebbat.h"
-#include "parser/parser_xmlvasttrafikse.h"
-#include "parser/parser_xmlrejseplanendk.h"
-#include "parser/parser_xmlsbbch.h"
-#include "parser/parser_xmlnri.h"
-#include "parser/parser_mobilebahnde.h"
-#include "parser/parser_ptvvicgovau.h"
-#include "parser/parser_sf_bay_efa.h"
-#include "parser/parser_sydney_efa.h"
-#include "parser/parser_ireland_efa.h"
-#include "parser/parser_dubai_efa.h"
-#include "parser/parser_ninetwo.h"
-#include "parser/parser_munich_efa.h"
-#include "parser/parser_salzburg_efa.h"
-#include "parser/parser_resrobot.h"
 
 class FahrplanParserThread : public QThread
 {
@@ -46,15 +30,26 @@ class FahrplanParserThread : public QThread
 public:
     explicit FahrplanParserThread(QObject *parent = 0);
 
+    // Each query returns its own reply, see FahrplanParserReply. Queries
+    // may be made once init() was called and run one after the other,
+    // their results are not broadcast. A query cancels the request made
+    // through the slots below which is still running, such a request, or
+    // cancelRequest(), fails all pending queries. Queries the backend does
+    // not support fail right away.
+    FahrplanParserReply *queryStationsByName(const QString &stationName);
+    FahrplanParserReply *queryStationsByCoordinates(qreal longitude, qreal latitude);
+    FahrplanParserReply *queryTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions);
+    FahrplanParserReply *queryJourney(const Station &departureStation, const Station &viaStation, const Station &arrivalStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions);
+    FahrplanParserReply *queryJourneyLater();
+    FahrplanParserReply *queryJourneyEarlier();
+    FahrplanParserReply *queryJourneyDetails(const QString &id);
+    // Time a query may run before it fails, 0 for no limit. Applies to
+    // queries started afterwards.
+    void setQueryTimeout(int msecs);
+
 signals:
     //Internal
-    void requestGetTimeTableForStation(const Station &stationName, const Station &directionStationName, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions);
-    void requestFindStationsByName(const QString &stationName);
-    void requestFindStationsByCoordinates(qreal longitude, qreal latitude);
-    void requestSearchJourney(const Station &departureStation, const Station &viaStation, const Station &arrivalStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions);
-    void requestSearchJourneyLater();
-    void requestSearchJourneyEarlier();
-    void requestGetJourneyDetails(const QString &id);
+    void requestQueued(const ParserAbstract::Request &request);
     void requestCancelRequest();
 
     //Real ones
@@ -65,6 +60,8 @@ signals:
     void errorOccured(QString msg);
 
 public slots:
+    // Does not block, the capabilities below are read from the registry and
+    // requests are queued until the thread has created the parser.
     void init(int parserIndex);
 
     void getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions);
@@ -83,13 +80,28 @@ public slots:
     QString name();
     QString shortName();
     QString uid() const;
+    int parserIndex() const;
     QStringList getTrainRestrictions();
 
 protected:
   void run();
 
+private slots:
+  // Called directly from the thread the parser emits in, drop results
+  // of cancelled requests and intern the strings of copied lists.
+  // Cancellation is checked under replyLock(), which cancelling holds
+  // too, so no result slips in between a cancel and its failed replies.
+  void parserStationsResult(const StationsList &result);
+  void parserJourneyResult(JourneyResultList *result);
+  void parserJourneyDetailsResult(JourneyDetailResultList *result);
+  void parserTimetableResult(const TimetableEntriesList &result);
+  void parserErrorOccured(QString msg);
+
 private:
-  bool m_ready;
+  friend class FahrplanParserReply;
+
+  // Lives in this thread, from run() on. Set and cleared under replyLock().
+  ParserAbstract *m_parser;
   int  i_parser;
 
   QStringList m_trainrestrictions;
@@ -100,6 +112,29 @@ private:
   QString m_name;
   QString m_short_name;
   QString m_uid;
+
+  // Queries, the first one is running if m_replyRunning is set. A running
+  // query whose reply was deleted stays in as NULL until its result came.
+  // Guarded by replyLock(), results arrive on parse workers.
+  QList<FahrplanParserReply *> m_replies;
+  bool m_replyRunning;
+  // Parser generation of the running query, its results are those of
+  // jobs in it.
+  int m_replyGeneration;
+  int m_queryTimeout;
+  // Requests made before run() created the parser, guarded by replyLock().
+  QList<ParserAbstract::Request> m_pendingRequests;
+
+  void queueRequest(const ParserAbstract::Request &request);
+  FahrplanParserReply *enqueueReply(FahrplanParserReply *reply);
+  static FahrplanParserReply *failedReply(FahrplanParserReply *reply, const QString &error);
+  void startNextReply();
+  void sendRequest(const ParserAbstract::Request &request);
+  bool isReplyResult(FahrplanParserReply::Type type) const;
+  void finishRunningReply(FahrplanParserReply *reply);
+  void failReplies(const QString &error);
+  static void dropReply(FahrplanParserReply *reply);
+  static void expireReply(FahrplanParserReply *reply);
 };
 
 #endif // FAHRPLAN_PARSER_THREAD_H
@@ -0,0 +1,156 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "fahrplan_settings.h"
+
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QSettings>
+#include <QTimer>
+
+// Delay between the first change and writing it to disk, in milliseconds.
+static const int FLUSH_DELAY = 1000;
+
+static FahrplanSettings *settingsInstance = NULL;
+
+static bool isBelow(const QString &key, const QString &group)
+{
+    return key == group || key.startsWith(group + "/");
+}
+
+class SettingsWriteJob : public QRunnable
+{
+public:
+    explicit SettingsWriteJob(const QList<QPair<QString, QVariant> > &changes)
+        : m_changes(changes)
+    {
+    }
+
+    void run()
+    {
+        QSettings settings(FAHRPLAN_SETTINGS_NAMESPACE, "fahrplan2");
+        for (int i = 0; i < m_changes.count(); ++i) {
+            if (m_changes.at(i).second.isValid())
+                settings.setValue(m_changes.at(i).first, m_changes.at(i).second);
+            else
+                settings.remove(m_changes.at(i).first);
+        }
+        settings.sync();
+    }
+
+private:
+    QList<QPair<QString, QVariant> > m_changes;
+};
+
+FahrplanSettings *FahrplanSettings::instance()
+{
+    if (!settingsInstance)
+        settingsInstance = new FahrplanSettings(QCoreApplication::instance());
+    return settingsInstance;
+}
+
+FahrplanSettings::FahrplanSettings(QObject *parent)
+    : QObject(parent)
+{
+    // Writes have to happen in order, so there is only one writer.
+    m_writer.setMaxThreadCount(1);
+
+    QSettings settings(FAHRPLAN_SETTINGS_NAMESPACE, "fahrplan2");
+    foreach (const QString &key, settings.allKeys())
+        m_values.insert(key, settings.value(key));
+
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_DELAY);
+    connect(m_flushTimer, SIGNAL(timeout()), SLOT(flush()));
+
+    if (parent)
+        connect(parent, SIGNAL(aboutToQuit()), SLOT(flush()));
+}
+
+FahrplanSettings::~FahrplanSettings()
+{
+    flush();
+    m_writer.waitForDone();
+    settingsInstance = NULL;
+}
+
+QVariant FahrplanSettings::value(const QString &key, const QVariant &defaultValue) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_values.value(key, defaultValue);
+}
+
+bool FahrplanSettings::contains(const QString &key) const
+{
+    QMutexLocker locker(&m_lock);
+    return m_values.contains(key);
+}
+
+void FahrplanSettings::setValue(const QString &key, const QVariant &value)
+{
+    {
+        QMutexLocker locker(&m_lock);
+        if (m_values.contains(key) && m_values.value(key) == value)
+            return;
+        m_values.insert(key, value);
+    }
+    queue(key, value);
+}
+
+void FahrplanSettings::remove(const QString &key)
+{
+    {
+        QMutexLocker locker(&m_lock);
+        QHash<QString, QVariant>::iterator it = m_values.begin();
+        while (it != m_values.end()) {
+            if (isBelow(it.key(), key))
+                it = m_values.erase(it);
+            else
+                ++it;
+        }
+    }
+    queue(key, QVariant());
+}
+
+void FahrplanSettings::queue(const QString &key, const QVariant &value)
+{
+    // Older changes the new one overrides are dropped, everything else
+    // keeps its order.
+    const bool removing = !value.isValid();
+    for (int i = m_pending.count() - 1; i >= 0; --i) {
+        const QString &pendingKey = m_pending.at(i).first;
+        if (pendingKey == key || (removing && isBelow(pendingKey, key)))
+            m_pending.removeAt(i);
+    }
+    m_pending.append(qMakePair(key, value));
+
+    if (!m_flushTimer->isActive())
+        m_flushTimer->start();
+}
+
+void FahrplanSettings::flush()
+{
+    m_flushTimer->stop();
+    if (m_pending.isEmpty())
+        return;
+
+    m_writer.start(new SettingsWriteJob(m_pending));
+    m_pending.clear();
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef FAHRPLAN_SETTINGS_H
+#define FAHRPLAN_SETTINGS_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVariant>
+
+class QTimer;
+
+/**
+ * @brief In memory copy of the application settings.
+ * All settings are read once at startup and served from memory. Changes
+ * are collected, repeated writes to the same key are merged, and they are
+ * written to disk in background shortly after, and at shutdown.
+ * Keys are full paths like QSettings uses them ("group/key"). Reading is
+ * thread safe, changes have to be made from the main thread.
+ */
+class FahrplanSettings : public QObject
+{
+    Q_OBJECT
+
+    public:
+        // The first call has to be made from the main thread.
+        static FahrplanSettings *instance();
+        ~FahrplanSettings();
+
+        QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+        bool contains(const QString &key) const;
+        void setValue(const QString &key, const QVariant &value);
+        // Removes the key and all keys below it, like QSettings does.
+        void remove(const QString &key);
+
+    public slots:
+        void flush();
+
+    private:
+        explicit FahrplanSettings(QObject *parent = 0);
+
+        mutable QMutex m_lock;
+        QHash<QString, QVariant> m_values;
+        // Changes not written yet, in order. An invalid value removes.
+        QList<QPair<QString, QVariant> > m_pending;
+        QTimer *m_flushTimer;
+        QThreadPool m_writer;
+
+        void queue(const QString &key, const QVariant &value);
+};
+
+#endif // FAHRPLAN_SETTINGS_H
@@ -0,0 +1,66 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "fahrplan_startup.h"
+
+#include <QDebug>
+
+static FahrplanStartup *startupInstance = NULL;
+
+FahrplanStartup::FahrplanStartup(QObject *parent)
+    : QObject(parent)
+    , m_interactive(false)
+{
+    m_clock.start();
+}
+
+FahrplanStartup *FahrplanStartup::instance()
+{
+    // Created before the application object, so it is not owned by it.
+    if (!startupInstance)
+        startupInstance = new FahrplanStartup();
+    return startupInstance;
+}
+
+void FahrplanStartup::mark(const char *phase)
+{
+    FahrplanStartup *startup = instance();
+    const QByteArray name(phase);
+    if (startup->m_phases.contains(name))
+        return;
+    startup->m_phases.insert(name);
+
+    qDebug() << "Startup:" << phase << "after" << startup->m_clock.elapsed() << "ms";
+}
+
+bool FahrplanStartup::isInteractive() const
+{
+    return m_interactive;
+}
+
+void FahrplanStartup::setInteractive()
+{
+    if (m_interactive)
+        return;
+
+    mark("First frame");
+    m_interactive = true;
+    emit interactive();
+}
@@ -0,0 +1,61 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef FAHRPLAN_STARTUP_H
+#define FAHRPLAN_STARTUP_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSet>
+
+/**
+ * @brief Tracks application startup.
+ * Phases are logged with the time elapsed since main() was entered, each
+ * phase only the first time it is reached. Work which is not needed to
+ * show the first frame waits for interactive() instead of running before.
+ */
+class FahrplanStartup : public QObject
+{
+    Q_OBJECT
+
+    public:
+        // The first call has to be made from the main thread, main() does
+        // it right away so the clock starts there.
+        static FahrplanStartup *instance();
+        static void mark(const char *phase);
+
+        bool isInteractive() const;
+
+    public slots:
+        // Called once the first frame is shown.
+        void setInteractive();
+
+    signals:
+        void interactive();
+
+    private:
+        explicit FahrplanStartup(QObject *parent = 0);
+
+        QElapsedTimer m_clock;
+        QSet<QByteArray> m_phases;
+        bool m_interactive;
+};
+
+#endif // FAHRPLAN_STARTUP_H
@@ -0,0 +1,223 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "fahrplan_stations_store.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+
+// Number of recently used stations kept per backend.
+static const int MAX_RECENT_STATIONS = 50;
+
+static const char *CONNECTION_NAME = "fahrplan-stations";
+
+FahrplanStationsStore::FahrplanStationsStore(QObject *parent)
+    : QObject(parent)
+    , m_lastRequest(0)
+{
+    // The database lives next to the settings file.
+    QSettings settings(FAHRPLAN_SETTINGS_NAMESPACE, "fahrplan2");
+    const QString dir = QFileInfo(settings.fileName()).absolutePath();
+    QDir().mkpath(dir);
+
+    m_thread = new QThread(this);
+    m_worker = new FahrplanStationsStoreWorker();
+    m_worker->moveToThread(m_thread);
+    connect(m_worker, SIGNAL(favoritesLoaded(int,QString,StationsList)), SIGNAL(favoritesLoaded(int,QString,StationsList)));
+    connect(m_worker, SIGNAL(recentsLoaded(int,QString,StationsList)), SIGNAL(recentsLoaded(int,QString,StationsList)));
+    m_thread->start();
+
+    QMetaObject::invokeMethod(m_worker, "open", Qt::QueuedConnection, Q_ARG(QString, dir + "/stations.sqlite"));
+}
+
+FahrplanStationsStore::~FahrplanStationsStore()
+{
+    // Queued writes are done before the connection is closed.
+    QMetaObject::invokeMethod(m_worker, "close", Qt::BlockingQueuedConnection);
+    m_thread->quit();
+    m_thread->wait();
+    delete m_worker;
+}
+
+int FahrplanStationsStore::loadFavorites(const QString &backend)
+{
+    const int request = ++m_lastRequest;
+    QMetaObject::invokeMethod(m_worker, "loadFavorites", Qt::QueuedConnection, Q_ARG(int, request), Q_ARG(QString, backend));
+    return request;
+}
+
+void FahrplanStationsStore::addFavorite(const QString &backend, const Station &station)
+{
+    QMetaObject::invokeMethod(m_worker, "addFavorite", Qt::QueuedConnection, Q_ARG(QString, backend), Q_ARG(Station, station));
+}
+
+void FahrplanStationsStore::removeFavorite(const QString &backend, const Station &station)
+{
+    QMetaObject::invokeMethod(m_worker, "removeFavorite", Qt::QueuedConnection, Q_ARG(QString, backend), Q_ARG(Station, station));
+}
+
+int FahrplanStationsStore::loadRecents(const QString &backend)
+{
+    const int request = ++m_lastRequest;
+    QMetaObject::invokeMethod(m_worker, "loadRecents", Qt::QueuedConnection, Q_ARG(int, request), Q_ARG(QString, backend));
+    return request;
+}
+
+void FahrplanStationsStore::addRecent(const QString &backend, const Station &station)
+{
+    QMetaObject::invokeMethod(m_worker, "addRecent", Qt::QueuedConnection, Q_ARG(QString, backend), Q_ARG(Station, station));
+}
+
+//-------------- FahrplanStationsStoreWorker
+
+FahrplanStationsStoreWorker::FahrplanStationsStoreWorker(QObject *parent)
+    : QObject(parent)
+    , m_open(false)
+{
+}
+
+void FahrplanStationsStoreWorker::open(const QString &fileName)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", CONNECTION_NAME);
+    db.setDatabaseName(fileName);
+    if (!db.open()) {
+        qWarning() << "Cannot open station store" << fileName << db.lastError().text();
+        return;
+    }
+    m_open = true;
+
+    exec("PRAGMA journal_mode=WAL");
+    exec("PRAGMA synchronous=NORMAL");
+    exec("CREATE TABLE IF NOT EXISTS favorites ("
+         "backend TEXT NOT NULL, id TEXT NOT NULL, name TEXT NOT NULL, "
+         "PRIMARY KEY (backend, id))");
+    exec("CREATE TABLE IF NOT EXISTS recents ("
+         "backend TEXT NOT NULL, id TEXT NOT NULL, name TEXT NOT NULL, "
+         "uses INTEGER NOT NULL DEFAULT 0, lastUsed INTEGER NOT NULL DEFAULT 0, "
+         "PRIMARY KEY (backend, id))");
+}
+
+void FahrplanStationsStoreWorker::close()
+{
+    if (!m_open)
+        return;
+
+    m_open = false;
+    QSqlDatabase::database(CONNECTION_NAME).close();
+    QSqlDatabase::removeDatabase(CONNECTION_NAME);
+}
+
+bool FahrplanStationsStoreWorker::exec(const QString &query, const QVariantList &values)
+{
+    if (!m_open)
+        return false;
+
+    QSqlQuery q(QSqlDatabase::database(CONNECTION_NAME));
+    q.prepare(query);
+    foreach (const QVariant &value, values)
+        q.addBindValue(value);
+    if (!q.exec()) {
+        qWarning() << "Station store query failed:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void FahrplanStationsStoreWorker::loadFavorites(int request, const QString &backend)
+{
+    StationsList favorites;
+
+    if (m_open) {
+        QSqlQuery q(QSqlDatabase::database(CONNECTION_NAME));
+        q.prepare("SELECT id, name FROM favorites WHERE backend = ?");
+        q.addBindValue(backend);
+        if (q.exec()) {
+            while (q.next()) {
+                Station station;
+                station.id = q.value(0);
+                station.name = q.value(1).toString();
+                favorites << station;
+            }
+        }
+    }
+
+    emit favoritesLoaded(request, backend, favorites);
+}
+
+void FahrplanStationsStoreWorker::addFavorite(const QString &backend, const Station &station)
+{
+    exec("INSERT OR REPLACE INTO favorites (backend, id, name) VALUES (?, ?, ?)",
+         QVariantList() << backend << station.id.toString() << station.name);
+}
+
+void FahrplanStationsStoreWorker::removeFavorite(const QString &backend, const Station &station)
+{
+    exec("DELETE FROM favorites WHERE backend = ? AND id = ?",
+         QVariantList() << backend << station.id.toString());
+}
+
+void FahrplanStationsStoreWorker::loadRecents(int request, const QString &backend)
+{
+    StationsList recents;
+
+    if (m_open) {
+        QSqlQuery q(QSqlDatabase::database(CONNECTION_NAME));
+        // Each use counts less the longer ago the station was last used,
+        // halving after about a week.
+        q.prepare("SELECT id, name FROM recents WHERE backend = ? "
+                  "ORDER BY uses / (1.0 + (? - lastUsed) / 604800.0) DESC");
+        q.addBindValue(backend);
+        q.addBindValue(QDateTime::currentDateTime().toTime_t());
+        if (q.exec()) {
+            while (q.next()) {
+                Station station;
+                station.id = q.value(0);
+                station.name = q.value(1).toString();
+                recents << station;
+            }
+        }
+    }
+
+    emit recentsLoaded(request, backend, recents);
+}
+
+void FahrplanStationsStoreWorker::addRecent(const QString &backend, const Station &station)
+{
+    if (!m_open)
+        return;
+
+    const QString id = station.id.toString();
+    const qint64 now = QDateTime::currentDateTime().toTime_t();
+
+    QSqlDatabase::database(CONNECTION_NAME).transaction();
+    exec("INSERT OR IGNORE INTO recents (backend, id, name) VALUES (?, ?, ?)",
+         QVariantList() << backend << id << station.name);
+    exec("UPDATE recents SET name = ?, uses = uses + 1, lastUsed = ? WHERE backend = ? AND id = ?",
+         QVariantList() << station.name << now << backend << id);
+    exec("DELETE FROM recents WHERE backend = ? AND id NOT IN "
+         "(SELECT id FROM recents WHERE backend = ? ORDER BY lastUsed DESC LIMIT ?)",
+         QVariantList() << backend << backend << MAX_RECENT_STATIONS);
+    QSqlDatabase::database(CONNECTION_NAME).commit();
+}
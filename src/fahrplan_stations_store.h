@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef FAHRPLAN_STATIONS_STORE_H
+#define FAHRPLAN_STATIONS_STORE_H
+
+#include "parser/parser_definitions.h"
+
+class QThread;
+class FahrplanStationsStoreWorker;
+
+/**
+ * @brief Persists favorite and recently used stations per backend.
+ * Stations are kept in a local SQLite database. All queries run on a
+ * worker thread, so adding or removing a station only queues a single row
+ * change and never blocks the GUI. Lists are delivered asynchronously
+ * through the loaded signals.
+ */
+class FahrplanStationsStore : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit FahrplanStationsStore(QObject *parent = 0);
+        ~FahrplanStationsStore();
+
+        // Returns the request number favoritesLoaded() is emitted with, so
+        // callers can tell their loads from those of others.
+        int loadFavorites(const QString &backend);
+        void addFavorite(const QString &backend, const Station &station);
+        void removeFavorite(const QString &backend, const Station &station);
+
+        // Recents are delivered ranked by frequency and recency of use,
+        // with the returned request number like loadFavorites().
+        int loadRecents(const QString &backend);
+        void addRecent(const QString &backend, const Station &station);
+
+    signals:
+        void favoritesLoaded(int request, const QString &backend, const StationsList &favorites);
+        void recentsLoaded(int request, const QString &backend, const StationsList &recents);
+
+    private:
+        QThread *m_thread;
+        FahrplanStationsStoreWorker *m_worker;
+        int m_lastRequest;
+};
+
+class FahrplanStationsStoreWorker : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit FahrplanStationsStoreWorker(QObject *parent = 0);
+
+    public slots:
+        void open(const QString &fileName);
+        void close();
+        void loadFavorites(int request, const QString &backend);
+        void addFavorite(const QString &backend, const Station &station);
+        void removeFavorite(const QString &backend, const Station &station);
+        void loadRecents(int request, const QString &backend);
+        void addRecent(const QString &backend, const Station &station);
+
+    signals:
+        void favoritesLoaded(int request, const QString &backend, const StationsList &favorites);
+        void recentsLoaded(int request, const QString &backend, const StationsList &recents);
+
+    private:
+        bool m_open;
+
+        bool exec(const QString &query, const QVariantList &values = QVariantList());
+};
+
+#endif // FAHRPLAN_STATIONS_STORE_H
@@ -175,14 +175,14 @@ void MainWindow::searchJourneyEarlierClicked()
 {
     ui->searchJourneyResults->clear();
     ui->searchJourneyResults->append("Searching...");
-    fahrplan->parser()->searchJourneyEarlier();
+    fahrplan->searchJourneyEarlier();
 }
 
 void MainWindow::searchJourneyLaterClicked()
 {
     ui->searchJourneyResults->clear();
     ui->searchJourneyResults->append("Searching...");
-    fahrplan->parser()->searchJourneyLater();
+    fahrplan->searchJourneyLater();
 }
 
 
@@ -223,7 +223,7 @@ void MainWindow::getJourneyDetailsClicked()
 {
     ui->getJourneyDetailsResults->clear();
     ui->getJourneyDetailsResults->append("Loading...");
-    fahrplan->parser()->getJourneyDetails(ui->journeyResultItemIds->currentText());
+    fahrplan->getJourneyDetails(ui->journeyResultItemIds->currentText());
 }
 
 void MainWindow::selectStationClicked()
@@ -158,7 +158,7 @@ Page {
                     detailsResultsPage.subTitleText2 = "";
                     detailsResultsPage.searchIndicatorVisible = true;
                     pageStack.push(detailsResultsPage);
-                    fahrplanBackend.parser.getJourneyDetails(model.id);
+                    fahrplanBackend.getJourneyDetails(model.id);
                 }
             }
         }
@@ -208,7 +208,7 @@ Page {
             iconId: "toolbar-back"
             onClicked: {
                 pageStack.pop();
-                fahrplanBackend.parser.cancelRequest();
+                fahrplanBackend.cancelRequest();
             }
         }
 
@@ -218,7 +218,7 @@ Page {
                 visible: !searchIndicatorVisible;
                 onClicked: {
                     searchIndicatorVisible = true
-                    fahrplanBackend.parser.searchJourneyEarlier();
+                    fahrplanBackend.searchJourneyEarlier();
                 }
             }
             ToolButton {
@@ -226,7 +226,7 @@ Page {
                 visible: !searchIndicatorVisible;
                 onClicked: {
                     searchIndicatorVisible = true
-                    fahrplanBackend.parser.searchJourneyLater();
+                    fahrplanBackend.searchJourneyLater();
                 }
             }
         }
@@ -39,7 +39,7 @@ Page {
                 enabled: (indicator.visible === false)
                 onClicked: {
                     indicator.visible = true;
-                    fahrplanBackend.parser.searchJourneyEarlier();
+                    fahrplanBackend.searchJourneyEarlier();
                 }
             }
         }
@@ -50,7 +50,7 @@ Page {
                 text: qsTr("Later")
                 onClicked: {
                     indicator.visible = true;
-                    fahrplanBackend.parser.searchJourneyLater();
+                    fahrplanBackend.searchJourneyLater();
                 }
             }
         }
@@ -123,7 +123,7 @@ Page {
                 delegate: JourneyDelegate {
                     onClicked: {
                         pageStack.push(detailsResultsPage);
-                        fahrplanBackend.parser.getJourneyDetails(model.id);
+                        fahrplanBackend.getJourneyDetails(model.id);
                     }
                 }
             }
@@ -144,7 +144,7 @@ Page {
             case PageStatus.Deactivating:
                 if (pageStack.depth === 1) {
                     indicator.visible = true;
-                    fahrplanBackend.parser.cancelRequest();
+                    fahrplanBackend.cancelRequest();
                 }
                 break;
         }
@@ -76,7 +76,7 @@ Page {
                               }
                           }
 
-                          currentBackend.currentIndex = fahrplanBackend.getSettingsValue("currentBackend", 0);
+                          currentBackend.currentIndex = fahrplanBackend.parserIndex();
                       }
                 }
                 onCurrentIndexChanged: {
@@ -30,7 +30,21 @@ Dialog {
     property string searchString
 
     onSearchStringChanged: {
-        fahrplanBackend.findStationsByName(searchString);
+        // Recent stations match right away, the backend is only asked
+        // once typing pauses.
+        fahrplanBackend.stationSuggestions.filter(searchString);
+        searchTimer.restart();
+    }
+
+    Timer {
+        id: searchTimer
+        interval: 500
+        onTriggered: {
+            if (searchString.length > 0)
+                fahrplanBackend.findStationsByName(searchString);
+            else
+                fahrplanBackend.stationSearchResults.clear();
+        }
     }
 
     property int type: FahrplanBackend.DepartureStation
@@ -78,6 +92,31 @@ Dialog {
                 }
             }
 
+            Column {
+                visible: (fahrplanBackend.stationSuggestions.count > 0)
+                width: parent.width
+
+                SectionHeader {
+                    text: qsTr("Recent")
+                }
+
+                ListView {
+                    model: fahrplanBackend.stationSuggestions
+                    width: parent.width
+                    height: contentHeight
+                    interactive: false
+
+                    currentIndex: -1
+
+                    delegate: StationDelegate {
+                        onStationSelected:  {
+                            searchTimer.stop();
+                            stationSelect.close();
+                        }
+                    }
+                }
+            }
+
             Column {
                 visible: (fahrplanBackend.stationSearchResults.count > 0)
                 width: parent.width
@@ -132,6 +171,7 @@ Dialog {
         switch (status) {
             case PageStatus.Activating:
                 gpsButton.visible = fahrplanBackend.parser.supportsGps();
+                fahrplanBackend.stationSuggestions.filter(searchString);
                 break;
         }
     }
@@ -30,6 +30,13 @@ Page {
         contentHeight: column.height
         contentWidth: parent.width
 
+        PullDownMenu {
+            MenuItem {
+                text: fahrplanBackend.liveTimetable ? qsTr("Stop live updates") : qsTr("Live updates")
+                onClicked: fahrplanBackend.liveTimetable = !fahrplanBackend.liveTimetable
+            }
+        }
+
         VerticalScrollDecorator {}
         Column {
             id: column
@@ -64,7 +71,8 @@ Page {
                 fahrplanBackend.getTimeTable();
                 break;
             case PageStatus.Deactivating:
-                fahrplanBackend.parser.cancelRequest();
+                fahrplanBackend.liveTimetable = false;
+                fahrplanBackend.cancelRequest();
                 break;
         }
     }
@@ -149,7 +149,7 @@ Page {
                     detailsResultsPage.subTitleText2 = "";
                     detailsResultsPage.searchIndicatorVisible = true;
                     pageStack.push(detailsResultsPage);
-                    fahrplanBackend.parser.getJourneyDetails(model.id);
+                    fahrplanBackend.getJourneyDetails(model.id);
                 }
             }
         }
@@ -205,7 +205,7 @@ Page {
             platformInverted: appWindow.platformInverted
             onClicked: {
                 pageStack.pop();
-                fahrplanBackend.parser.cancelRequest();
+                fahrplanBackend.cancelRequest();
             }
         }
 
@@ -215,7 +215,7 @@ Page {
             platformInverted: appWindow.platformInverted
             onClicked: {
                 searchIndicatorVisible = true;
-                fahrplanBackend.parser.searchJourneyEarlier();
+                fahrplanBackend.searchJourneyEarlier();
             }
         }
         ToolButton {
@@ -224,7 +224,7 @@ Page {
             platformInverted: appWindow.platformInverted
             onClicked: {
                 searchIndicatorVisible = true;
-                fahrplanBackend.parser.searchJourneyLater();
+                fahrplanBackend.searchJourneyLater();
             }
         }
     }
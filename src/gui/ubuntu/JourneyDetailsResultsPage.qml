@@ -33,6 +33,15 @@ Page {
 
     property JourneyDetailResultList currentResult;
 
+    head.actions: [
+        Action {
+            iconName: "calendar"
+            text: qsTr("Add to calendar")
+            enabled: !searchIndicator.visible && fahrplanBackend.supportsCalendar
+            onTriggered: fahrplanBackend.addJourneyDetailResultToCalendar(currentResult);
+        }
+    ]
+
 //    tools: journeyDetailResultsToolbar
     Item {
         id: searchResults
@@ -170,7 +170,7 @@ Page {
                 width: (parent.width - parent.spacing) / 2
                 onClicked: {
                     searchIndicatorVisible = true
-                    fahrplanBackend.parser.searchJourneyEarlier()
+                    fahrplanBackend.searchJourneyEarlier()
                 }
             }
             Button {
@@ -178,7 +178,7 @@ Page {
                 width: (parent.width - parent.spacing) / 2
                 onClicked: {
                     searchIndicatorVisible = true
-                    fahrplanBackend.parser.searchJourneyLater()
+                    fahrplanBackend.searchJourneyLater()
                 }
             }
         }
@@ -212,7 +212,7 @@ Page {
                     var component = Qt.createComponent("JourneyDetailsResultsPage.qml")
                     pageStack.push(component,
                                    {titleText: qsTr("Loading details"), subTitleText: qsTr("please wait..."), searchIndicatorVisible: true});
-                    fahrplanBackend.parser.getJourneyDetails(id);
+                    fahrplanBackend.getJourneyDetails(id);
                 }
             }
 
@@ -342,7 +342,7 @@ Page {
 //            iconId: "toolbar-back"
 //            onClicked: {
 //                pageStack.pop();
-//                fahrplanBackend.parser.cancelRequest();
+//                fahrplanBackend.cancelRequest();
 //            }
 //        }
 
@@ -352,7 +352,7 @@ Page {
 //                visible: !searchIndicatorVisible;
 //                onClicked: {
 //                    searchIndicatorVisible = true
-//                    fahrplanBackend.parser.searchJourneyEarlier();
+//                    fahrplanBackend.searchJourneyEarlier();
 //                }
 //            }
 //            ToolButton {
@@ -360,7 +360,7 @@ Page {
 //                visible: !searchIndicatorVisible;
 //                onClicked: {
 //                    searchIndicatorVisible = true
-//                    fahrplanBackend.parser.searchJourneyLater();
+//                    fahrplanBackend.searchJourneyLater();
 //                }
 //            }
 //        }
@@ -17,6 +17,8 @@
 **
 ****************************************************************************/
 
+#include <QtCore/QSettings>
+#include <QtCore/QTimer>
 #include <QtCore/QTranslator>
 
 #if defined(BUILD_FOR_HARMATTAN) || defined(BUILD_FOR_MAEMO_5) || defined(BUILD_FOR_SYMBIAN) || defined(BUILD_FOR_BLACKBERRY)
@@ -55,10 +57,12 @@
 #endif
 
 #include "fahrplan.h"
+#include "fahrplan_startup.h"
 #include "parser/parser_abstract.h"
 #include "fahrplan_parser_thread.h"
 #include "fahrplan_calendar_manager.h"
 #include "models/stationsearchresults.h"
+#include "models/stationsuggestions.h"
 #include "models/favorites.h"
 #include "models/timetable.h"
 #include "models/trainrestrictions.h"
@@ -68,6 +72,8 @@ Q_DECL_EXPORT
 #endif
 int main(int argc, char *argv[])
 {
+    FahrplanStartup::mark("Main");
+
     #if defined(BUILD_FOR_SAILFISHOS)
         //To support calendar access
         #if defined(BUILD_FOR_OPENREPOS)
@@ -88,6 +94,7 @@ int main(int argc, char *argv[])
             app->setWindowIcon(QIcon(":/fahrplan2_64.png"));
         #endif
     #endif
+    FahrplanStartup::mark("Application created");
 
     QString localeName = QLocale().name();
 
@@ -97,6 +104,7 @@ int main(int argc, char *argv[])
     QTranslator translator;
     translator.load(QString("fahrplan_%1").arg(localeName), ":/translations");
     app->installTranslator(&translator);
+    FahrplanStartup::mark("Translations loaded");
 
     qDebug()<<"Startup";
 
@@ -116,6 +124,9 @@ int main(int argc, char *argv[])
         qmlRegisterUncreatableType<StationSearchResults>("Fahrplan", 1, 0, "StationSearchResults"
             , "StationSearchResults cannot be created from QML. "
               "Access it through FahrplanBackend.stationSearchResults.");
+        qmlRegisterUncreatableType<StationSuggestions>("Fahrplan", 1, 0, "StationSuggestions"
+            , "StationSuggestions cannot be created from QML. "
+              "Access it through FahrplanBackend.stationSuggestions.");
         qmlRegisterUncreatableType<Favorites>("Fahrplan", 1, 0, "Favorites"
             , "Favorites cannot be created from QML. "
               "Access it through FahrplanBackend.favorites.");
@@ -129,6 +140,7 @@ int main(int argc, char *argv[])
         qmlRegisterType<JourneyResultItem>("Fahrplan", 1, 0, "JourneyResultItem");
         qmlRegisterType<JourneyDetailResultList>("Fahrplan", 1, 0, "JourneyDetailResultList");
         qmlRegisterType<JourneyDetailResultItem>("Fahrplan", 1, 0, "JourneyDetailResultItem");
+        FahrplanStartup::mark("Types registered");
 
         #if defined(BUILD_FOR_SAILFISHOS)
             QQuickView *view = SailfishApp::createView();
@@ -139,6 +151,15 @@ int main(int argc, char *argv[])
         #else
             QDeclarativeView* view = new QDeclarativeView();
         #endif
+        FahrplanStartup::mark("View created");
+
+        // Deferred work starts once the first frame is on screen. Qt 4 has
+        // no signal for it, there the event loop running is close enough.
+        #if defined(BUILD_FOR_QT5)
+            QObject::connect(view, SIGNAL(frameSwapped()), FahrplanStartup::instance(), SLOT(setInteractive()));
+        #else
+            QTimer::singleShot(0, FahrplanStartup::instance(), SLOT(setInteractive()));
+        #endif
 
         #if defined(BUILD_FOR_HARMATTAN)
             qDebug()<<"Harmattan";
@@ -201,7 +222,9 @@ int main(int argc, char *argv[])
         qDebug()<<"Desktop";
         MainWindow w;
         w.show();
+        QTimer::singleShot(0, FahrplanStartup::instance(), SLOT(setInteractive()));
     #endif
+    FahrplanStartup::mark("UI loaded");
 
     qDebug()<<"Exec";
 
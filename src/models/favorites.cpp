@@ -18,14 +18,18 @@
 ****************************************************************************/
 
 #include "fahrplan_parser_thread.h"
+#include "fahrplan_settings.h"
+#include "fahrplan_startup.h"
+#include "fahrplan_stations_store.h"
 #include "models/favorites.h"
 
-#include <QSettings>
-
 Favorites::Favorites(Fahrplan *parent)
     : StationsListModel(parent)
+    , m_store(parent->stationsStore())
+    , m_loadRequest(0)
 {
-    m_settings = new QSettings(FAHRPLAN_SETTINGS_NAMESPACE, "fahrplan2", this);
+    m_settings = FahrplanSettings::instance();
+    connect(m_store, SIGNAL(favoritesLoaded(int,QString,StationsList)), SLOT(onFavoritesLoaded(int,QString,StationsList)));
 }
 
 QVariant Favorites::data(const QModelIndex &index, int role) const
@@ -43,20 +47,26 @@ QVariant Favorites::data(const QModelIndex &index, int role) const
 
 void Favorites::addToFavorites(const Station &station)
 {
-    if (!isFavorite(station)) {
-        beginResetModel();
-        m_list.append(station);
-        qSort(m_list);
-        endResetModel();
+    if (isFavorite(station))
+        return;
 
-        emit countChanged();
+    const int index = qUpperBound(m_list.begin(), m_list.end(), station) - m_list.begin();
+    beginInsertRows(QModelIndex(), index, index);
+    m_list.insert(index, station);
+    m_index.insert(station);
+    endInsertRows();
 
-        saveToSettings();
-    }
+    emit countChanged();
+    emit favoriteChanged(station);
+
+    m_store->addFavorite(m_backend, station);
 }
 
 void Favorites::removeFromFavorites(const Station &station)
 {
+    if (!isFavorite(station))
+        return;
+
     int index = m_list.indexOf(station);
     if (index < 0)
         return;
@@ -70,58 +80,89 @@ void Favorites::removeFromFavorites(int index)
         return;
 
     beginRemoveRows(QModelIndex(), index, index);
-    m_list.removeAt(index);
+    const Station station = m_list.takeAt(index);
+    m_index.remove(station);
     endRemoveRows();
 
+    if (m_loadRequest)
+        m_removedWhileLoading.insert(station);
+
     emit countChanged();
+    emit favoriteChanged(station);
 
-    saveToSettings();
+    m_store->removeFavorite(m_backend, station);
 }
 
+/*
+ * Switches to the favorites of the current backend. They are loaded by the
+ * store in background and show up once onFavoritesLoaded() gets them.
+ */
 void Favorites::reload()
 {
-    if (!m_settings->group().isEmpty())
-        m_settings->endGroup();
-    m_settings->beginGroup(qobject_cast<Fahrplan *>(QObject::parent())->parser()->uid());
-
-    beginResetModel();
-    m_list.clear();
-    loadFavorites();
-    endResetModel();
-}
+    m_backend = qobject_cast<Fahrplan *>(QObject::parent())->parser()->uid();
 
-bool Favorites::isFavorite(const Station &station) const
-{
-    return m_list.contains(station);
+    if (!m_list.isEmpty()) {
+        beginRemoveRows(QModelIndex(), 0, m_list.count() - 1);
+        m_list.clear();
+        m_index.clear();
+        endRemoveRows();
+        emit countChanged();
+    }
+
+    m_removedWhileLoading.clear();
+    migrateSettings();
+    m_loadRequest = m_store->loadFavorites(m_backend);
 }
 
-void Favorites::loadFavorites()
+/*
+ * Favorites added meanwhile are already shown, so the loaded ones are merged
+ * in. Loads of other instances or for a backend switched away from are
+ * ignored.
+ */
+void Favorites::onFavoritesLoaded(int request, const QString &backend, const StationsList &favorites)
 {
-    int size = m_settings->beginReadArray("favorites");
-    for (int k = 0; k < size; ++k) {
-        m_settings->setArrayIndex(k);
+    if (request != m_loadRequest || backend != m_backend)
+        return;
+    m_loadRequest = 0;
 
-        Station station;
-        station.id = m_settings->value("id");
-        station.name = m_settings->value("name").toString();
-        m_list << station;
+    FahrplanStartup::mark("Favorites loaded");
+
+    bool changed = false;
+    foreach (const Station &station, favorites) {
+        if (m_index.contains(station) || m_removedWhileLoading.contains(station))
+            continue;
+
+        const int index = qUpperBound(m_list.begin(), m_list.end(), station) - m_list.begin();
+        beginInsertRows(QModelIndex(), index, index);
+        m_list.insert(index, station);
+        m_index.insert(station);
+        endInsertRows();
+        changed = true;
     }
-    m_settings->endArray();
-    qSort(m_list);
+    m_removedWhileLoading.clear();
+
+    if (changed)
+        emit countChanged();
 }
 
-void Favorites::saveToSettings()
+bool Favorites::isFavorite(const Station &station) const
+{
+    return m_index.contains(station);
+}
+
+// Favorites used to be stored in the settings file, move them to the store.
+void Favorites::migrateSettings()
 {
-    // Clean up before storing. If we don't do it and the list is shorter than
-    // the previous one was, there will be junk entries left in the .ini file.
-    m_settings->remove("favorites");
-
-    m_settings->beginWriteArray("favorites");
-    int size = m_list.size();
-    for (int k = 0; k < size; ++k) {
-        m_settings->setArrayIndex(k);
-        m_settings->setValue("id", m_list.at(k).id);
-        m_settings->setValue("name", m_list.at(k).name);
+    // Settings arrays are numbered from 1.
+    const QString array = m_backend + "/favorites";
+    int size = m_settings->value(array + "/size", 0).toInt();
+    for (int k = 1; k <= size; ++k) {
+        Station station;
+        station.id = m_settings->value(QString("%1/%2/id").arg(array).arg(k));
+        station.name = m_settings->value(QString("%1/%2/name").arg(array).arg(k)).toString();
+        m_store->addFavorite(m_backend, station);
     }
-    m_settings->endArray();
+
+    if (size > 0)
+        m_settings->remove(array);
 }
@@ -23,7 +23,10 @@
 #include "parser/parser_definitions.h"
 #include "models/stationslistmodel.h"
 
-class QSettings;
+#include <QSet>
+
+class FahrplanStationsStore;
+class FahrplanSettings;
 class Favorites: public StationsListModel
 {
     Q_OBJECT
@@ -41,11 +44,24 @@ public slots:
     void removeFromFavorites(const Station &station);
     void removeFromFavorites(int index);
 
+signals:
+    void favoriteChanged(const Station &station);
+
+private slots:
+    void onFavoritesLoaded(int request, const QString &backend, const StationsList &favorites);
+
 private:
-    QSettings *m_settings;
+    FahrplanStationsStore *m_store;
+    QString m_backend;
+    // Load in flight, 0 if none
+    int m_loadRequest;
+    // Removed while loading, so the load must not bring them back.
+    QSet<Station> m_removedWhileLoading;
+    FahrplanSettings *m_settings;
+    // Same stations as m_list, for constant time lookups.
+    QSet<Station> m_index;
 
-    void loadFavorites();
-    void saveToSettings();
+    void migrateSettings();
 };
 
 #endif // FAHRPLAN_FAVORITES_MANAGER_H
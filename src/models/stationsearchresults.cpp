@@ -27,7 +27,7 @@ StationSearchResults::StationSearchResults(Fahrplan *parent)
 {
     // When favorites change, we need to trigger view update
     // so that stars states in the search results are updated.
-    connect(parent->favorites(), SIGNAL(countChanged()), this, SLOT(onCountChanged()));
+    connect(parent->favorites(), SIGNAL(favoriteChanged(Station)), this, SLOT(onFavoriteChanged(Station)));
 }
 
 QVariant StationSearchResults::data(const QModelIndex &index, int role) const
@@ -48,8 +48,6 @@ void StationSearchResults::addToFavorites(int index)
         return;
 
     qobject_cast<Fahrplan *>(QObject::parent())->favorites()->addToFavorites(m_list.at(index));
-    QModelIndex i = this->index(index, 0);
-    emit dataChanged(i, i);
 }
 
 void StationSearchResults::removeFromFavorites(int index)
@@ -58,11 +56,15 @@ void StationSearchResults::removeFromFavorites(int index)
         return;
 
     qobject_cast<Fahrplan *>(QObject::parent())->favorites()->removeFromFavorites(m_list.at(index));
-    QModelIndex i = this->index(index, 0);
-    emit dataChanged(i, i);
 }
 
-void StationSearchResults::onCountChanged()
+void StationSearchResults::onFavoriteChanged(const Station &station)
 {
-    emit dataChanged(createIndex(0, 0), createIndex(rowCount() - 1, 0));
+    // Only the rows showing that station change their star.
+    for (int row = 0; row < m_list.count(); ++row) {
+        if (m_list.at(row) == station) {
+            QModelIndex i = index(row, 0);
+            emit dataChanged(i, i);
+        }
+    }
 }
@@ -36,7 +36,7 @@ public slots:
     void removeFromFavorites(int index);
 
 private slots:
-    void onCountChanged();
+    void onFavoriteChanged(const Station &station);
 };
 
 #endif // STATIONSEARCHRESULTS_H
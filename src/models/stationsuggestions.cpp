@@ -0,0 +1,49 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "stationsuggestions.h"
+
+// Number of suggestions shown at once.
+static const int MAX_SUGGESTIONS = 8;
+
+StationSuggestions::StationSuggestions(Fahrplan *parent)
+    : StationSearchResults(parent)
+{
+}
+
+void StationSuggestions::setSuggestions(const StationsList &list)
+{
+    m_suggestions = list;
+    filter(m_filter);
+}
+
+void StationSuggestions::filter(const QString &text)
+{
+    m_filter = text.trimmed();
+
+    StationsList matches;
+    foreach (const Station &station, m_suggestions) {
+        if (matches.count() >= MAX_SUGGESTIONS)
+            break;
+        if (m_filter.isEmpty() || station.name.contains(m_filter, Qt::CaseInsensitive))
+            matches << station;
+    }
+
+    setStationsList(matches);
+}
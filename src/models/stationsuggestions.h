@@ -0,0 +1,48 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef STATIONSUGGESTIONS_H
+#define STATIONSUGGESTIONS_H
+
+#include "stationsearchresults.h"
+
+/**
+ * @brief Recently used stations of the current backend, best first.
+ * Stations are ranked by how often and how recently they were selected.
+ * The list is available before anything is typed and can be narrowed
+ * down locally while the user types, without asking the backend.
+ */
+class StationSuggestions: public StationSearchResults
+{
+    Q_OBJECT
+
+public:
+    explicit StationSuggestions(Fahrplan *parent = 0);
+
+    void setSuggestions(const StationsList &list);
+
+public slots:
+    void filter(const QString &text);
+
+private:
+    StationsList m_suggestions;
+    QString m_filter;
+};
+
+#endif // STATIONSUGGESTIONS_H
@@ -19,6 +19,8 @@
 
 #include "timetable.h"
 
+#include <QSet>
+
 Timetable::Timetable(QObject *parent)
     : QAbstractListModel(parent)
 {
@@ -82,12 +84,118 @@ QVariant Timetable::data(const QModelIndex &index, int role) const
     }
 }
 
-void Timetable::setTimetableEntries(const TimetableEntriesList &list)
+static bool entriesEqual(const TimetableEntry &a, const TimetableEntry &b)
 {
-    beginResetModel();
-    m_list = list;
-    endResetModel();
-    emit countChanged();
+    return a.currentStation == b.currentStation
+            && a.destinationStation == b.destinationStation
+            && a.trainType == b.trainType
+            && a.platform == b.platform
+            && a.time == b.time
+            && a.miscInfo == b.miscInfo
+            && a.latitude == b.latitude
+            && a.longitude == b.longitude;
+}
+
+// Identifies a departure across refreshes by train, time and destination.
+// Repeated keys get a running number, so every key is unique in a list.
+QStringList Timetable::entryKeys(const TimetableEntriesList &list)
+{
+    QStringList keys;
+    QHash<QString, int> seen;
+    foreach (const TimetableEntry &entry, list) {
+        const QString key = entry.trainType + QChar(0x1f) + entry.time.toString(Qt::ISODate) + QChar(0x1f) + entry.destinationStation;
+        const int n = seen.value(key);
+        seen.insert(key, n + 1);
+        keys << key + QChar(0x1f) + QString::number(n);
+    }
+    return keys;
+}
+
+/*
+ * Updates the model to the given entries with as few changes as possible,
+ * so refreshing a board keeps the delegates and the scroll position.
+ * Vanished departures are removed first, then the remaining rows are walked
+ * in the new order, moving, inserting and updating rows where needed.
+ */
+bool Timetable::setTimetableEntries(const TimetableEntriesList &list)
+{
+    const int oldCount = m_list.count();
+    bool changed = false;
+    const QStringList newKeys = entryKeys(list);
+    QStringList keys = entryKeys(m_list);
+
+    const QSet<QString> newKeySet = newKeys.toSet();
+    for (int end = keys.count() - 1; end >= 0; --end) {
+        if (newKeySet.contains(keys.at(end)))
+            continue;
+        int start = end;
+        while (start > 0 && !newKeySet.contains(keys.at(start - 1)))
+            --start;
+        changed = true;
+        beginRemoveRows(QModelIndex(), start, end);
+        for (int i = end; i >= start; --i) {
+            m_list.removeAt(i);
+            keys.removeAt(i);
+        }
+        endRemoveRows();
+        end = start;
+    }
+
+    for (int i = 0; i < list.count(); ++i) {
+        const QString &key = newKeys.at(i);
+
+        if (i < keys.count() && keys.at(i) == key) {
+            if (!entriesEqual(m_list.at(i), list.at(i))) {
+                changed = true;
+                m_list[i] = list.at(i);
+                emit dataChanged(index(i), index(i));
+            }
+            continue;
+        }
+
+        changed = true;
+
+        const int from = keys.indexOf(key, i + 1);
+        if (from < 0) {
+            beginInsertRows(QModelIndex(), i, i);
+            m_list.insert(i, list.at(i));
+            keys.insert(i, key);
+            endInsertRows();
+            continue;
+        }
+
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), i);
+        m_list.move(from, i);
+        keys.move(from, i);
+        endMoveRows();
+
+        if (!entriesEqual(m_list.at(i), list.at(i))) {
+            m_list[i] = list.at(i);
+            emit dataChanged(index(i), index(i));
+        }
+    }
+
+    if (m_list.count() != oldCount)
+        emit countChanged();
+
+    return changed;
+}
+
+int Timetable::secsToNextDeparture() const
+{
+    const QTime now = QTime::currentTime();
+    int next = -1;
+    foreach (const TimetableEntry &entry, m_list) {
+        if (!entry.time.isValid())
+            continue;
+        int secs = now.secsTo(entry.time);
+        // Boards may reach past midnight.
+        if (secs < -12 * 3600)
+            secs += 24 * 3600;
+        if (secs >= 0 && (next < 0 || secs < next))
+            next = secs;
+    }
+    return next;
 }
 
 void Timetable::clear()
@@ -49,7 +49,10 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = CurrentStation) const;
 
-    void setTimetableEntries(const TimetableEntriesList &list);
+    // Returns false if the new entries equal the shown ones.
+    bool setTimetableEntries(const TimetableEntriesList &list);
+    // Seconds until the next entry leaves, -1 if none is ahead.
+    int secsToNextDeparture() const;
 
 public slots:
     void clear();
@@ -59,6 +62,8 @@ signals:
 
 private:
     TimetableEntriesList m_list;
+
+    static QStringList entryKeys(const TimetableEntriesList &list);
 };
 
 #endif // TIMETABLERESULTS_H
@@ -0,0 +1,40 @@
+# The parser layer: backends, the result definitions and the registry. It
+# has no GUI dependencies and is shared by the application and fahrplan-cli.
+
+QT += network xml
+
+# Zlib todo for other systems ugly hack
+!unix: INCLUDEPATH += f:/QtSdk/Qt5.4.0/5.4/mingw491_32/include/QtZlib
+unix:!symbian: LIBS += -lz
+
+HEADERS += \
+    $$PWD/parser_abstract.h \
+    $$PWD/parser_definitions.h \
+    $$PWD/parser_hafasxml.h \
+    $$PWD/parser_hafasbinary.h \
+    $$PWD/parser_efa.h \
+    $$PWD/parser_json.h \
+    $$PWD/parser_stringpool.h \
+    $$PWD/parser_registry.h
+SOURCES += \
+    $$PWD/parser_abstract.cpp \
+    $$PWD/parser_definitions.cpp \
+    $$PWD/parser_hafasxml.cpp \
+    $$PWD/parser_hafasbinary.cpp \
+    $$PWD/parser_efa.cpp \
+    $$PWD/parser_json.cpp \
+    $$PWD/parser_stringpool.cpp \
+    $$PWD/parser_registry.cpp
+
+# Backends built in, all of them by default. Single region builds can pick
+# their own, e.g. qmake "FAHRPLAN_BACKENDS=xmlsbbch".
+isEmpty(FAHRPLAN_BACKENDS) {
+    FAHRPLAN_BACKENDS = mobilebahnde xmloebbat xmlrejseplanendk xmlsbbch xmlnri \
+        xmlvasttrafikse ptvvicgovau sydney_efa sf_bay_efa ireland_efa dubai_efa \
+        ninetwo munich_efa salzburg_efa resrobot
+}
+for(backend, FAHRPLAN_BACKENDS) {
+    HEADERS += $$PWD/parser_$${backend}.h
+    SOURCES += $$PWD/parser_$${backend}.cpp
+    DEFINES += FAHRPLAN_BACKEND_$$upper($$backend)
+}
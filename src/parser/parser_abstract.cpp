@@ -19,56 +19,331 @@
 
 #include "parser_abstract.h"
 
+#include <QCoreApplication>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QTimer>
 
 #include <zlib.h>
 
-#ifdef BUILD_FOR_QT5
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
-#else
-#include <QScriptEngine>
-#include <QScriptValue>
-#endif
+// Parsing of replies is CPU bound and independent of the network, so it is
+// done on a shared worker pool instead of the parsers network threads. The
+// network threads only send requests and receive replies.
+Q_GLOBAL_STATIC(QThreadPool, parseWorkerPool)
+
+// Holds a finished reply in memory, so it can be read on a parse worker
+// after the original reply has been deleted.
+class ParserBufferedReply : public QNetworkReply
+{
+public:
+    ParserBufferedReply(QNetworkReply *reply, const QByteArray &data)
+        : m_data(data)
+        , m_offset(0)
+    {
+        setUrl(reply->url());
+        setRequest(reply->request());
+        setOperation(reply->operation());
+        setError(reply->error(), reply->errorString());
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, reply->attribute(QNetworkRequest::HttpStatusCodeAttribute));
+        foreach (const QByteArray &header, reply->rawHeaderList())
+            setRawHeader(header, reply->rawHeader(header));
+        open(QIODevice::ReadOnly);
+    }
+
+    void abort() {}
+
+    bool isSequential() const
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const
+    {
+        return m_data.size() - m_offset + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        qint64 size = qMin(maxSize, qint64(m_data.size() - m_offset));
+        memcpy(data, m_data.constData() + m_offset, size);
+        m_offset += size;
+        return size;
+    }
+
+private:
+    QByteArray m_data;
+    int m_offset;
+};
+
+// Handles the queued jobs of a parser, one after the other.
+class ParserJobRunner : public QRunnable
+{
+public:
+    explicit ParserJobRunner(ParserAbstract *parser)
+        : m_parser(parser)
+    {
+    }
+
+    void run()
+    {
+        m_parser->runJobs();
+    }
+
+private:
+    ParserAbstract *m_parser;
+};
 
 ParserAbstract::ParserAbstract(QObject *parent) :
-    QObject(parent)
+    QObject(parent), jobsRunning(false), cancelGeneration(0), activeGeneration(0), requestGeneration(0),
+    pendingResultScope(NULL), currentResultScope(NULL), previousResultScope(NULL)
 {
+    qRegisterMetaType<ParserAbstract::Request>("ParserAbstract::Request");
+
     NetworkManager = new QNetworkAccessManager(this);
     connect(NetworkManager, SIGNAL(finished(QNetworkReply*)), this, SLOT(networkReplyFinished(QNetworkReply*)));
 
     currentRequestState = FahrplanNS::noneRequest;
+    lastRequest = NULL;
 
-    requestTimeout = new QTimer();
+    // Parented, so the timer follows the parser into its thread.
+    requestTimeout = new QTimer(this);
 
     connect(requestTimeout, SIGNAL(timeout()), this, SLOT(networkReplyTimedOut()));
 
     userAgent = "Mozilla/5.0 (Windows NT 6.1; WOW64; rv:13.0) Gecko/20100101 Firefox/13.0";
+
+    // Connected first, so they run before anyone else gets the results.
+    connect(this, SIGNAL(journeyResult(JourneyResultList*)), this, SLOT(internJourneyResult(JourneyResultList*)), Qt::DirectConnection);
+    connect(this, SIGNAL(journeyDetailsResult(JourneyDetailResultList*)), this, SLOT(internJourneyDetailsResult(JourneyDetailResultList*)), Qt::DirectConnection);
+    connect(this, SIGNAL(journeyResult(JourneyResultList*)), this, SLOT(commitResultScope()), Qt::DirectConnection);
 }
 
 ParserAbstract::~ParserAbstract()
 {
     delete requestTimeout;
     delete NetworkManager;
+
+    if (pendingResultScope)
+        pendingResultScope->deleteLater();
+    if (currentResultScope)
+        currentResultScope->deleteLater();
+    if (previousResultScope)
+        previousResultScope->deleteLater();
+}
+
+static QObject *createResultScope()
+{
+    QObject *scope = new QObject();
+    scope->moveToThread(QCoreApplication::instance()->thread());
+    return scope;
+}
+
+void ParserAbstract::beginResultScope()
+{
+    // A search which never delivered its results leaves its scope behind.
+    if (pendingResultScope)
+        releaseResultScope(pendingResultScope);
+    pendingResultScope = createResultScope();
+}
+
+void ParserAbstract::adoptResultObject(QObject *result)
+{
+    QObject *scope = pendingResultScope;
+    if (!scope) {
+        if (!currentResultScope)
+            currentResultScope = createResultScope();
+        scope = currentResultScope;
+    }
+
+    if (result->thread() != scope->thread())
+        result->moveToThread(scope->thread());
+    result->setParent(scope);
+    uninternedResults.insert(result);
+}
+
+void ParserAbstract::releaseResultScope(QObject *scope)
+{
+    foreach (QObject *result, scope->children())
+        uninternedResults.remove(result);
+    scope->deleteLater();
+}
+
+ParserStringPool *ParserAbstract::stringPool()
+{
+    return &strings;
+}
+
+void ParserAbstract::internJourneyResult(JourneyResultList *result)
+{
+    if (result && uninternedResults.remove(result))
+        strings.intern(result);
+}
+
+void ParserAbstract::internJourneyDetailsResult(JourneyDetailResultList *result)
+{
+    if (result && uninternedResults.remove(result))
+        strings.intern(result);
+}
+
+void ParserAbstract::commitResultScope()
+{
+    // Cancelled results never reach the UI, it still shows the current ones.
+    if (!pendingResultScope || isCancelled())
+        return;
+
+    // The previous results were replaced one delivery ago, the UI has seen
+    // the current ones before this deferred delete runs.
+    if (previousResultScope)
+        releaseResultScope(previousResultScope);
+    previousResultScope = currentResultScope;
+    currentResultScope = pendingResultScope;
+    pendingResultScope = NULL;
 }
 
 void ParserAbstract::networkReplyFinished(QNetworkReply *networkReply)
 {
-    FahrplanNS::curReqStates internalRequestState = currentRequestState;
+    disconnect(networkReply, SIGNAL(downloadProgress(qint64,qint64)), this, 0);
+    networkReply->deleteLater();
 
-    disconnect(lastRequest, SIGNAL(downloadProgress(qint64,qint64)), 0, 0);
-    requestTimeout->stop();
+    // A superseded request may finish after the next one was sent.
+    if (networkReply == lastRequest) {
+        requestTimeout->stop();
+        lastRequest = NULL;
+    }
 
-    lastRequest = NULL;
+    Job job;
+    job.replyState = static_cast<FahrplanNS::curReqStates>(networkReply->property("requestState").toInt());
+    job.generation = networkReply->property("generation").toInt();
+    job.timedOut = networkReply->property("timedOut").toBool();
 
-    //We overwrite the currentRequestState to noneRequest here, because this allows us to set a new one
-    //if needed inside the parser
-    currentRequestState = FahrplanNS::noneRequest;
+    // Results of cancelled requests are dropped anyway.
+    if (job.generation != cancelGeneration.fetchAndAddOrdered(0))
+        return;
+
+    QByteArray data = networkReply->readAll();
+    if (job.replyState == FahrplanNS::getTimeTableForStationRequest)
+        updateTimetableCache(networkReply, data);
+    job.reply = new ParserBufferedReply(networkReply, data);
+    enqueueJob(job);
+}
 
+void ParserAbstract::updateTimetableCache(QNetworkReply *networkReply, QByteArray &data)
+{
+    const int status = networkReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 304 && networkReply->url() == timetableCache.url) {
+        data = timetableCache.data;
+        return;
+    }
+
+    timetableCache.url = QUrl();
+    timetableCache.data.clear();
+    if (networkReply->error() != QNetworkReply::NoError || networkReply->operation() != QNetworkAccessManager::GetOperation)
+        return;
+
+    timetableCache.etag = networkReply->rawHeader("ETag");
+    timetableCache.lastModified = networkReply->rawHeader("Last-Modified");
+    if (timetableCache.etag.isEmpty() && timetableCache.lastModified.isEmpty())
+        return;
+
+    timetableCache.url = networkReply->url();
+    timetableCache.data = data;
+}
+
+void ParserAbstract::waitForParsing()
+{
+    QMutexLocker locker(&jobLock);
+    while (jobsRunning)
+        jobsDone.wait(&jobLock);
+}
+
+void ParserAbstract::queueRequest(const ParserAbstract::Request &request)
+{
+    Job job;
+    job.request = request;
+    job.reply = NULL;
+    job.timedOut = false;
+    job.generation = cancelGeneration.fetchAndAddOrdered(0);
+    enqueueJob(job);
+}
+
+void ParserAbstract::enqueueJob(const Job &job)
+{
+    QMutexLocker locker(&jobLock);
+    jobs.append(job);
+    if (jobsRunning)
+        return;
+
+    jobsRunning = true;
+    parseWorkerPool()->start(new ParserJobRunner(this));
+}
+
+void ParserAbstract::runJobs()
+{
+    QMutexLocker locker(&jobLock);
+    while (!jobs.isEmpty()) {
+        const Job job = jobs.takeFirst();
+        locker.unlock();
+        runJob(job);
+        locker.relock();
+    }
+    jobsRunning = false;
+    jobsDone.wakeAll();
+}
+
+void ParserAbstract::runJob(const Job &job)
+{
+    activeGeneration = job.generation;
+
+    if (job.reply) {
+        // Allows the parser to send a follow up request while parsing.
+        currentRequestState = FahrplanNS::noneRequest;
+        if (job.timedOut)
+            emit errorOccured(tr("Request timed out."));
+        else if (!isCancelled())
+            parseReply(job.replyState, job.reply);
+        job.reply->deleteLater();
+        return;
+    }
+
+    // The request still running was cancelled before this one was queued,
+    // its reply will be dropped.
+    if (requestGeneration != job.generation)
+        currentRequestState = FahrplanNS::noneRequest;
+
+    const Request &request = job.request;
+    switch (request.state) {
+    case FahrplanNS::stationsByNameRequest:
+        findStationsByName(request.text);
+        break;
+    case FahrplanNS::stationsByCoordinatesRequest:
+        findStationsByCoordinates(request.longitude, request.latitude);
+        break;
+    case FahrplanNS::getTimeTableForStationRequest:
+        getTimeTableForStation(request.first, request.second, request.dateTime, request.mode, request.trainrestrictions);
+        break;
+    case FahrplanNS::searchJourneyRequest:
+        searchJourney(request.first, request.second, request.third, request.dateTime, request.mode, request.trainrestrictions);
+        break;
+    case FahrplanNS::searchJourneyLaterRequest:
+        searchJourneyLater();
+        break;
+    case FahrplanNS::searchJourneyEarlierRequest:
+        searchJourneyEarlier();
+        break;
+    case FahrplanNS::journeyDetailsRequest:
+        getJourneyDetails(request.text);
+        break;
+    default:
+        break;
+    }
+}
+
+void ParserAbstract::parseReply(FahrplanNS::curReqStates internalRequestState, QNetworkReply *networkReply)
+{
     if (internalRequestState == FahrplanNS::stationsByNameRequest) {
         parseStationsByName(networkReply);
     } else if (internalRequestState == FahrplanNS::stationsByCoordinatesRequest) {
@@ -88,7 +363,28 @@ void ParserAbstract::networkReplyFinished(QNetworkReply *networkReply)
     }
 }
 
+int ParserAbstract::cancel()
+{
+    return cancelGeneration.fetchAndAddOrdered(1) + 1;
+}
+
+bool ParserAbstract::isCancelled() const
+{
+    return activeGeneration != cancelGeneration.fetchAndAddOrdered(0);
+}
+
+int ParserAbstract::generation() const
+{
+    return activeGeneration;
+}
+
 void ParserAbstract::cancelRequest()
+{
+    cancel();
+    abortRequest();
+}
+
+void ParserAbstract::abortRequest()
 {
     requestTimeout->stop();
     if (lastRequest) {
@@ -98,6 +394,24 @@ void ParserAbstract::cancelRequest()
 
 void ParserAbstract::sendHttpRequest(QUrl url, QByteArray data)
 {
+    // Nothing will answer a cancelled request, the parser is free again.
+    if (isCancelled()) {
+        currentRequestState = FahrplanNS::noneRequest;
+        return;
+    }
+
+    // Requests are sent from the parser thread, which owns the network
+    // access manager. The reply remembers what it was requested for.
+    requestGeneration = activeGeneration;
+    QMetaObject::invokeMethod(this, "startHttpRequest", Qt::QueuedConnection, Q_ARG(QUrl, url), Q_ARG(QByteArray, data),
+                              Q_ARG(int, currentRequestState), Q_ARG(int, activeGeneration));
+}
+
+void ParserAbstract::startHttpRequest(const QUrl &url, const QByteArray &data, int requestState, int generation)
+{
+    if (generation != cancelGeneration.fetchAndAddOrdered(0))
+        return;
+
     QNetworkRequest request;
     request.setUrl(url);
 #if defined(BUILD_FOR_QT5)
@@ -111,37 +425,26 @@ void ParserAbstract::sendHttpRequest(QUrl url, QByteArray data)
         request.setRawHeader("Accept-Encoding", acceptEncoding);
     }
 
+    if (requestState == FahrplanNS::getTimeTableForStationRequest && data.isNull() && url == timetableCache.url) {
+        if (!timetableCache.etag.isEmpty())
+            request.setRawHeader("If-None-Match", timetableCache.etag);
+        if (!timetableCache.lastModified.isEmpty())
+            request.setRawHeader("If-Modified-Since", timetableCache.lastModified);
+    }
+
     if (data.isNull()) {
         lastRequest = NetworkManager->get(request);
     } else {
         lastRequest = NetworkManager->post(request, data);
     }
+    lastRequest->setProperty("requestState", requestState);
+    lastRequest->setProperty("generation", generation);
 
     requestTimeout->start(30000);
 
     connect(lastRequest, SIGNAL(downloadProgress(qint64,qint64)), this, SLOT(networkReplyDownloadProgress(qint64,qint64)));
 }
 
-QVariantMap ParserAbstract::parseJson(const QByteArray &json) const
-{
-    QVariantMap doc;
-#ifdef BUILD_FOR_QT5
-    doc = QJsonDocument::fromJson(json).toVariant().toMap();
-#else
-    QString tmp(json);
-    // Validation of JSON according to RFC4627, section 6
-    if (tmp.replace(QRegExp("\"(\\\\.|[^\"\\\\])*\""), "")
-           .contains(QRegExp("[^,:{}\\[\\]0-9.\\-+Eaeflnr-u \\n\\r\\t]")))
-        return doc;
-
-    QScriptEngine *engine = new QScriptEngine();
-    doc = engine->evaluate("(" + json + ")").toVariant().toMap();
-    delete engine;
-#endif
-
-    return doc;
-}
-
 void ParserAbstract::networkReplyDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
     Q_UNUSED(bytesReceived)
@@ -152,8 +455,10 @@ void ParserAbstract::networkReplyDownloadProgress(qint64 bytesReceived, qint64 b
 
 void ParserAbstract::networkReplyTimedOut()
 {
-    cancelRequest();
-    emit errorOccured(tr("Request timed out."));
+    // The error is reported when the aborted reply is handled.
+    if (lastRequest)
+        lastRequest->setProperty("timedOut", true);
+    abortRequest();
 }
 
 void ParserAbstract::sendHttpRequest(QUrl url)
@@ -163,28 +468,27 @@ void ParserAbstract::sendHttpRequest(QUrl url)
 
 bool ParserAbstract::supportsGps()
 {
-    return false;
+    return capabilities() & SupportsGps;
 }
 
 bool ParserAbstract::supportsVia()
 {
-    return false;
+    return capabilities() & SupportsVia;
 }
 
 bool ParserAbstract::supportsTimeTable()
 {
-    return false;
+    return capabilities() & SupportsTimeTable;
 }
 
 bool ParserAbstract::supportsTimeTableDirection()
 {
-    return false;
+    return capabilities() & SupportsTimeTableDirection;
 }
 
 QStringList ParserAbstract::getTrainRestrictions()
 {
-    QStringList result;
-    return result;
+    return getTrainRestrictionList();
 }
 
 void ParserAbstract::getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTtime, Mode mode, int trainrestrictions)
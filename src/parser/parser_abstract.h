@@ -20,9 +20,15 @@
 #ifndef PARSER_ABSTRACT_H
 #define PARSER_ABSTRACT_H
 
+#include <QAtomicInt>
+#include <QMutex>
 #include <QObject>
 #include <QStringList>
+#include <QUrl>
+#include <QSet>
+#include <QWaitCondition>
 #include "parser_definitions.h"
+#include "parser_stringpool.h"
 
 class QNetworkAccessManager;
 class QNetworkReply;
@@ -35,14 +41,64 @@ class ParserAbstract : public QObject
 
 public:
     enum Mode { Departure = 0, Arrival = 1 };
+    enum Capability {
+        NoCapabilities = 0x0,
+        SupportsGps = 0x1,
+        SupportsVia = 0x2,
+        SupportsTimeTable = 0x4,
+        SupportsTimeTableDirection = 0x8
+    };
+
+    // Arguments of a request, see queueRequest().
+    struct Request
+    {
+        Request() : state(FahrplanNS::noneRequest), mode(Departure), trainrestrictions(0), longitude(0), latitude(0) {}
+
+        FahrplanNS::curReqStates state;
+        QString text;
+        Station first;
+        Station second;
+        Station third;
+        QDateTime dateTime;
+        Mode mode;
+        int trainrestrictions;
+        qreal longitude;
+        qreal latitude;
+    };
 
     explicit ParserAbstract(QObject *parent = 0);
     ~ParserAbstract();
 
+    // Every backend redeclares the static descriptions it changes, so
+    // ParserRegistry can read them without creating the parser. The
+    // virtual counterparts forward to them.
     static QString getName() { return "Abstract"; }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return getName(); }
+    static QString getShortName() { return getName(); }
+    virtual QString shortName() { return getShortName(); }
     virtual QString uid() { return metaObject()->className(); }
+    static int getCapabilities() { return NoCapabilities; }
+    virtual int capabilities() { return getCapabilities(); }
+    static QStringList getTrainRestrictionList() { return QStringList(); }
+
+    // Blocks until all queued requests and replies have been handled.
+    void waitForParsing();
+
+    // Cancels the running request and its parsing. Unlike cancelRequest()
+    // this is thread safe and takes effect immediately. Returns the
+    // generation requests queued from now on belong to.
+    int cancel();
+    // True if the request currently handled by this parser was cancelled.
+    // Parsers check it in long loops, results of it are dropped anyway.
+    bool isCancelled() const;
+    // Generation of the job currently handled, so results can be told
+    // apart from those of requests queued before the last cancel().
+    int generation() const;
+
+    // Journey and detail results are interned before they are emitted the
+    // first time. Only to be used while a job of this parser is handled,
+    // e.g. from direct connections to its result signals.
+    ParserStringPool *stringPool();
 
 public slots:
     virtual void getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTtime, ParserAbstract::Mode mode, int trainrestrictions);
@@ -59,6 +115,11 @@ public slots:
     virtual QStringList getTrainRestrictions();
     void cancelRequest();
 
+    // Handles the request on a parse worker, after everything queued
+    // before. Requests and replies of one parser are handled one at a time,
+    // as they share its state, so the parser thread itself never waits.
+    void queueRequest(const ParserAbstract::Request &request);
+
 signals:
     void stationsResult(const StationsList &result);
     void journeyResult(JourneyResultList *result);
@@ -71,6 +132,12 @@ protected slots:
     void networkReplyDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
     void networkReplyTimedOut();
 
+private slots:
+    void commitResultScope();
+    void internJourneyResult(JourneyResultList *result);
+    void internJourneyDetailsResult(JourneyDetailResultList *result);
+    void startHttpRequest(const QUrl &url, const QByteArray &data, int requestState, int generation);
+
 protected:
     QString userAgent;
     QNetworkAccessManager *NetworkManager;
@@ -88,8 +155,78 @@ protected:
     virtual void parseJourneyDetails(QNetworkReply *networkReply);
     void sendHttpRequest(QUrl url, QByteArray data);
     void sendHttpRequest(QUrl url);
-    QVariantMap parseJson(const QByteArray &data) const;
     QByteArray gzipDecompress(QByteArray compressData);
+
+    // Result objects are owned per search. A parser starts a scope when it
+    // begins parsing a new search, every result object it creates is
+    // adopted into it. The scope replaces the current one once its journey
+    // result is delivered, and is freed as a unit after the next search was
+    // delivered as well, so the UI never sees a result vanish.
+    void beginResultScope();
+    template <class T> T *adoptResult(T *result)
+    {
+        adoptResultObject(result);
+        return result;
+    }
+
+private:
+    friend class ParserJobRunner;
+
+    // A queued request, or a finished reply, with the cancel generation
+    // it belongs to.
+    struct Job
+    {
+        Request request;
+        FahrplanNS::curReqStates replyState;
+        QNetworkReply *reply;
+        bool timedOut;
+        int generation;
+    };
+
+    QMutex jobLock;
+    QWaitCondition jobsDone;
+    QList<Job> jobs;
+    bool jobsRunning;
+
+    // Bumped on every cancel. A request remembers the value it was queued
+    // at and is cancelled as soon as they differ.
+    mutable QAtomicInt cancelGeneration;
+    // Of the job being handled, and of the last request sent. Only used
+    // while handling jobs.
+    int activeGeneration;
+    int requestGeneration;
+
+    // Last timetable reply and its validators. Refreshing the same board
+    // sends a conditional request, an unchanged board is not downloaded.
+    struct {
+        QUrl url;
+        QByteArray etag;
+        QByteArray lastModified;
+        QByteArray data;
+    } timetableCache;
+
+    void updateTimetableCache(QNetworkReply *networkReply, QByteArray &data);
+
+    // Scopes live in the main thread, where the results are used.
+    QObject *pendingResultScope;
+    QObject *currentResultScope;
+    QObject *previousResultScope;
+
+    ParserStringPool strings;
+    // Adopted results which were not emitted yet. Results already handed
+    // out are used by other threads and must not be changed anymore.
+    QSet<QObject *> uninternedResults;
+
+    void releaseResultScope(QObject *scope);
+    void abortRequest();
+    void adoptResultObject(QObject *result);
+
+    void enqueueJob(const Job &job);
+    void runJobs();
+    void runJob(const Job &job);
+    void parseReply(FahrplanNS::curReqStates requestState, QNetworkReply *networkReply);
 };
 
+Q_DECLARE_METATYPE(ParserAbstract::Request)
+
 #endif // PARSER_ABSTRACT_H
@@ -19,6 +19,8 @@
 
 #include "parser_definitions.h"
 
+#include <algorithm>
+
 
 //-------------- Station
 
@@ -38,8 +40,16 @@ bool Station::operator ==(const Station &other) const
 {
     if (valid != other.valid)
         return false;
-    if (id != other.id)
+    // Ids coming from the same parser session are interned, so equal ids
+    // usually share their data and need no character comparison.
+    if (id.type() == QVariant::String && other.id.type() == QVariant::String) {
+        const QString a = id.toString();
+        const QString b = other.id.toString();
+        if (a.constData() != b.constData() && a != b)
+            return false;
+    } else if (id != other.id) {
         return false;
+    }
     // Comparing ID should be enough, cause it's uniquie identifier
     // of the station. Everything else is details.
 //    if (name != other.name)
@@ -60,6 +70,11 @@ bool Station::operator <(const Station &other) const
     return name < other.name;
 }
 
+uint qHash(const Station &station)
+{
+    return qHash(station.id.toString());
+}
+
 
 //-------------- TimetableEntry
 
@@ -71,19 +86,477 @@ TimetableEntry::TimetableEntry()
 
 //------------- JourneyResultList
 
+// Times are kept as minutes since midnight as long as they are in the usual
+// "hh:mm" format and durations as long as they are in "h:mm" format. Anything
+// else is stored as an interned string, encoded as a negative index, so the
+// original text is always returned unchanged.
+
+static QString formatTime(int minutes)
+{
+    return QString("%1:%2").arg(minutes / 60, 2, 10, QChar('0')).arg(minutes % 60, 2, 10, QChar('0'));
+}
+
+static QString formatDuration(int minutes)
+{
+    return QString("%1:%2").arg(minutes / 60).arg(minutes % 60, 2, 10, QChar('0'));
+}
+
+static int toMinutes(const QString &text)
+{
+    const int colon = text.indexOf(':');
+    if (colon < 1)
+        return -1;
+
+    bool hoursOk;
+    bool minutesOk;
+    const int h = text.left(colon).toInt(&hoursOk);
+    const int m = text.mid(colon + 1).toInt(&minutesOk);
+    if (!hoursOk || !minutesOk || h < 0 || h > 9999 || m < 0 || m > 59)
+        return -1;
+    return h * 60 + m;
+}
+
+// Julian day of 1970-01-01
+static const qint32 epochJulianDay = 2440588;
+
+static qint32 toStamp(const QDateTime &dateTime)
+{
+    if (!dateTime.isValid())
+        return -1;
+    const qint32 days = qint32(dateTime.date().toJulianDay()) - epochJulianDay;
+    if (days < 0)
+        return -1;
+    return days * 1440 + dateTime.time().hour() * 60 + dateTime.time().minute();
+}
+
+static QDateTime fromStamp(qint32 stamp)
+{
+    if (stamp < 0)
+        return QDateTime();
+    return QDateTime(QDate::fromJulianDay(stamp / 1440 + epochJulianDay), QTime(stamp % 1440 / 60, stamp % 60));
+}
+
+// Orders rows by the key of the sort order, unknown values last. Rows with
+// equal keys are ordered by departure.
+class JourneyRowLessThan
+{
+public:
+    JourneyRowLessThan(const JourneyResultList *list, JourneyResultList::SortOrder order)
+        : m_list(list)
+        , m_order(order)
+    {
+    }
+
+    bool operator()(int left, int right) const
+    {
+        const qint64 leftKey = key(left);
+        const qint64 rightKey = key(right);
+        if (leftKey != rightKey)
+            return leftKey < rightKey;
+        return unknownLast(m_list->departureStamp(left)) < unknownLast(m_list->departureStamp(right));
+    }
+
+private:
+    const JourneyResultList *m_list;
+    JourneyResultList::SortOrder m_order;
+
+    static qint64 unknownLast(int value)
+    {
+        return value < 0 ? Q_INT64_C(0x100000000) : value;
+    }
+
+    qint64 key(int row) const
+    {
+        switch (m_order) {
+        case JourneyResultList::FastestOrder:
+            return unknownLast(m_list->durationMinutes(row));
+        case JourneyResultList::FewestTransfersOrder:
+            return unknownLast(m_list->transferCount(row));
+        case JourneyResultList::EarliestArrivalOrder:
+            return unknownLast(m_list->arrivalStamp(row));
+        case JourneyResultList::DepartureOrder:
+            return unknownLast(m_list->departureStamp(row));
+        default:
+            return 0;
+        }
+    }
+};
+
+JourneyResultList::JourneyResultList(QObject *parent)
+    : QObject(parent)
+    , m_sortOrder(OriginalOrder)
+{
+}
+
 qreal JourneyResultList::itemcount()
 {
-    return m_items.count();
+    if (m_sortOrder == OriginalOrder && m_productFilter.isEmpty())
+        return m_ids.count();
+    return m_view.count();
+}
+
+int JourneyResultList::row(int index) const
+{
+    if (m_sortOrder == OriginalOrder && m_productFilter.isEmpty())
+        return index;
+    return m_view.at(index);
 }
 
 JourneyResultItem *JourneyResultList::getItem(int index)
 {
-    return  m_items.at(index);
+    if (index < 0 || index >= itemcount())
+        return NULL;
+    index = row(index);
+
+    QMutexLocker locker(&m_viewsLock);
+    if (m_views.count() < m_ids.count())
+        m_views.resize(m_ids.count());
+
+    JourneyResultItem *view = m_views.at(index);
+    if (!view) {
+        view = new JourneyResultItem();
+        view->m_list = this;
+        view->m_row = index;
+        // Views can be requested from any thread, but live with the list.
+        view->moveToThread(thread());
+        view->setParent(this);
+        m_views[index] = view;
+    }
+    return view;
 }
 
 void JourneyResultList::appendItem(JourneyResultItem *item)
 {
-    m_items.append(item);
+    m_ids.append(item->id());
+    m_dates.append(item->date().isValid() ? qint32(item->date().toJulianDay()) : 0);
+    m_departureTimes.append(encodeTime(item->departureTime()));
+    m_arrivalTimes.append(encodeTime(item->arrivalTime()));
+    m_durations.append(encodeDuration(item->duration()));
+    m_transfers.append(encodeCount(item->transfers()));
+    m_trainTypes.append(intern(item->trainType()));
+    m_miscInfos.append(intern(item->miscInfo()));
+    m_departureStamps.append(-1);
+    m_arrivalStamps.append(-1);
+    m_products.append(productMask(item->trainType()));
+    m_internalData1.append(item->internalData1());
+    m_internalData2.append(item->internalData2());
+    setStamps(m_ids.count() - 1, item->departureDateTime(), item->arrivalDateTime());
+
+    if (m_sortOrder != OriginalOrder || !m_productFilter.isEmpty())
+        updateView();
+}
+
+JourneyResultList::SortOrder JourneyResultList::sortOrder() const
+{
+    return m_sortOrder;
+}
+
+void JourneyResultList::setSortOrder(SortOrder order)
+{
+    if (order == m_sortOrder)
+        return;
+
+    m_sortOrder = order;
+    updateView();
+}
+
+QStringList JourneyResultList::products() const
+{
+    return m_productNames;
+}
+
+QStringList JourneyResultList::productFilter() const
+{
+    return m_productFilter;
+}
+
+void JourneyResultList::setProductFilter(const QStringList &products)
+{
+    if (products == m_productFilter)
+        return;
+
+    m_productFilter = products;
+    updateView();
+}
+
+void JourneyResultList::updateView()
+{
+    quint32 allowed = 0;
+    foreach (const QString &product, m_productFilter) {
+        const int bit = m_productNames.indexOf(product);
+        if (bit >= 0)
+            allowed |= 1u << bit;
+    }
+
+    m_view.clear();
+    for (int i = 0; i < m_ids.count(); ++i) {
+        if (m_productFilter.isEmpty() || (m_products.at(i) & ~allowed) == 0)
+            m_view.append(i);
+    }
+
+    if (m_sortOrder != OriginalOrder)
+        std::stable_sort(m_view.begin(), m_view.end(), JourneyRowLessThan(this, m_sortOrder));
+
+    emit viewChanged();
+}
+
+// The product of a part of the train type is its leading letters, so
+// "ICE 595", "S1" and "Bus 42" become "ICE", "S" and "Bus".
+quint32 JourneyResultList::productMask(const QString &trainType)
+{
+    quint32 mask = 0;
+    foreach (const QString &part, trainType.split(',', QString::SkipEmptyParts)) {
+        const QString token = part.trimmed();
+        int length = 0;
+        while (length < token.length() && token.at(length).isLetter())
+            ++length;
+        const QString product = length > 0 ? token.left(length) : token;
+        if (product.isEmpty())
+            continue;
+
+        int bit = m_productNames.indexOf(product);
+        if (bit < 0 && m_productNames.count() < 32) {
+            bit = m_productNames.count();
+            m_productNames.append(product);
+        }
+        if (bit >= 0)
+            mask |= 1u << bit;
+    }
+    return mask;
+}
+
+// Explicit times win. Otherwise they are derived from the date and the
+// display times, an arrival before the departure is on the next day.
+void JourneyResultList::setStamps(int row, const QDateTime &departure, const QDateTime &arrival)
+{
+    qint32 departureStamp = toStamp(departure);
+    if (departureStamp < 0 && m_dates.at(row) > epochJulianDay && m_departureTimes.at(row) >= 0)
+        departureStamp = (m_dates.at(row) - epochJulianDay) * 1440 + m_departureTimes.at(row);
+
+    qint32 arrivalStamp = toStamp(arrival);
+    if (arrivalStamp < 0 && m_dates.at(row) > epochJulianDay && m_arrivalTimes.at(row) >= 0) {
+        arrivalStamp = (m_dates.at(row) - epochJulianDay) * 1440 + m_arrivalTimes.at(row);
+        if (departureStamp >= 0 && arrivalStamp < departureStamp)
+            arrivalStamp += 1440;
+    }
+
+    m_departureStamps[row] = departureStamp;
+    m_arrivalStamps[row] = arrivalStamp;
+}
+
+QString JourneyResultList::id(int row) const
+{
+    return m_ids.at(row);
+}
+
+QDate JourneyResultList::date(int row) const
+{
+    return m_dates.at(row) ? QDate::fromJulianDay(m_dates.at(row)) : QDate();
+}
+
+QString JourneyResultList::departureTime(int row) const
+{
+    return decodeTime(m_departureTimes.at(row));
+}
+
+int JourneyResultList::departureMinutes(int row) const
+{
+    return qMax(m_departureTimes.at(row), -1);
+}
+
+QString JourneyResultList::arrivalTime(int row) const
+{
+    return decodeTime(m_arrivalTimes.at(row));
+}
+
+int JourneyResultList::arrivalMinutes(int row) const
+{
+    return qMax(m_arrivalTimes.at(row), -1);
+}
+
+QString JourneyResultList::trainType(int row) const
+{
+    return m_strings.at(m_trainTypes.at(row));
+}
+
+QString JourneyResultList::duration(int row) const
+{
+    const qint32 value = m_durations.at(row);
+    if (value < 0)
+        return m_strings.at(-value - 1);
+    return formatDuration(value);
+}
+
+int JourneyResultList::durationMinutes(int row) const
+{
+    if (m_durations.at(row) >= 0)
+        return m_durations.at(row);
+    if (m_departureStamps.at(row) >= 0 && m_arrivalStamps.at(row) >= 0)
+        return m_arrivalStamps.at(row) - m_departureStamps.at(row);
+    return -1;
+}
+
+QString JourneyResultList::transfers(int row) const
+{
+    const qint32 value = m_transfers.at(row);
+    if (value < 0)
+        return m_strings.at(-value - 1);
+    return QString::number(value);
+}
+
+int JourneyResultList::transferCount(int row) const
+{
+    return qMax(m_transfers.at(row), -1);
+}
+
+int JourneyResultList::departureStamp(int row) const
+{
+    return m_departureStamps.at(row);
+}
+
+int JourneyResultList::arrivalStamp(int row) const
+{
+    return m_arrivalStamps.at(row);
+}
+
+QDateTime JourneyResultList::departureDateTime(int row) const
+{
+    return fromStamp(m_departureStamps.at(row));
+}
+
+QDateTime JourneyResultList::arrivalDateTime(int row) const
+{
+    return fromStamp(m_arrivalStamps.at(row));
+}
+
+QStringList JourneyResultList::products(int row) const
+{
+    QStringList result;
+    for (int bit = 0; bit < m_productNames.count(); ++bit) {
+        if (m_products.at(row) & (1u << bit))
+            result.append(m_productNames.at(bit));
+    }
+    return result;
+}
+
+QString JourneyResultList::miscInfo(int row) const
+{
+    return m_strings.at(m_miscInfos.at(row));
+}
+
+QString JourneyResultList::internalData1(int row) const
+{
+    return m_internalData1.at(row);
+}
+
+QString JourneyResultList::internalData2(int row) const
+{
+    return m_internalData2.at(row);
+}
+
+qint32 JourneyResultList::intern(const QString &text)
+{
+    QHash<QString, qint32>::ConstIterator it = m_stringIndex.constFind(text);
+    if (it != m_stringIndex.constEnd())
+        return it.value();
+
+    const qint32 index = m_strings.count();
+    m_strings.append(text);
+    m_stringIndex.insert(text, index);
+    return index;
+}
+
+qint32 JourneyResultList::encodeTime(const QString &time)
+{
+    const int minutes = toMinutes(time);
+    if (minutes >= 0 && formatTime(minutes) == time)
+        return minutes;
+    return -intern(time) - 1;
+}
+
+qint32 JourneyResultList::encodeDuration(const QString &duration)
+{
+    const int minutes = toMinutes(duration);
+    if (minutes >= 0 && formatDuration(minutes) == duration)
+        return minutes;
+    return -intern(duration) - 1;
+}
+
+qint32 JourneyResultList::encodeCount(const QString &count)
+{
+    bool ok;
+    const int value = count.toInt(&ok);
+    if (ok && value >= 0 && QString::number(value) == count)
+        return value;
+    return -intern(count) - 1;
+}
+
+QString JourneyResultList::decodeTime(qint32 value) const
+{
+    if (value < 0)
+        return m_strings.at(-value - 1);
+    return formatTime(value);
+}
+
+void JourneyResultList::setId(int row, const QString &id)
+{
+    m_ids[row] = id;
+}
+
+void JourneyResultList::setDate(int row, const QDate &date)
+{
+    m_dates[row] = date.isValid() ? qint32(date.toJulianDay()) : 0;
+}
+
+void JourneyResultList::setDepartureTime(int row, const QString &departureTime)
+{
+    m_departureTimes[row] = encodeTime(departureTime);
+}
+
+void JourneyResultList::setArrivalTime(int row, const QString &arrivalTime)
+{
+    m_arrivalTimes[row] = encodeTime(arrivalTime);
+}
+
+void JourneyResultList::setTrainType(int row, const QString &trainType)
+{
+    m_trainTypes[row] = intern(trainType);
+    m_products[row] = productMask(trainType);
+}
+
+void JourneyResultList::setDuration(int row, const QString &duration)
+{
+    m_durations[row] = encodeDuration(duration);
+}
+
+void JourneyResultList::setTransfers(int row, const QString &transfers)
+{
+    m_transfers[row] = encodeCount(transfers);
+}
+
+void JourneyResultList::setMiscInfo(int row, const QString &miscInfo)
+{
+    m_miscInfos[row] = intern(miscInfo);
+}
+
+void JourneyResultList::setDepartureDateTime(int row, const QDateTime &departureDateTime)
+{
+    m_departureStamps[row] = toStamp(departureDateTime);
+}
+
+void JourneyResultList::setArrivalDateTime(int row, const QDateTime &arrivalDateTime)
+{
+    m_arrivalStamps[row] = toStamp(arrivalDateTime);
+}
+
+void JourneyResultList::setInternalData1(int row, const QString &internalData1)
+{
+    m_internalData1[row] = internalData1;
+}
+
+void JourneyResultList::setInternalData2(int row, const QString &internalData2)
+{
+    m_internalData2[row] = internalData2;
 }
 
 QString JourneyResultList::departureStation() const
@@ -128,104 +601,170 @@ void JourneyResultList::setTimeInfo(const QString &timeInfo)
 
 //------------- JourneyResultItem
 
+// A standalone item keeps its own values until it is appended to a list.
+// Items returned by JourneyResultList::getItem() read and write the list.
+
+JourneyResultItem::JourneyResultItem(QObject *parent)
+    : QObject(parent)
+    , m_list(NULL)
+    , m_row(-1)
+{
+}
+
 QString JourneyResultItem::id() const
 {
-    return m_id;
+    return m_list ? m_list->id(m_row) : m_id;
 }
 
 void JourneyResultItem::setId(const QString &id)
 {
-    m_id = id;
+    if (m_list)
+        m_list->setId(m_row, id);
+    else
+        m_id = id;
 }
 
 QDate JourneyResultItem::date() const
 {
-    return m_date;
+    return m_list ? m_list->date(m_row) : m_date;
 }
 
 void JourneyResultItem::setDate(const QDate &date)
 {
-    m_date = date;
+    if (m_list)
+        m_list->setDate(m_row, date);
+    else
+        m_date = date;
 }
 
 QString JourneyResultItem::departureTime() const
 {
-    return m_departureTime;
+    return m_list ? m_list->departureTime(m_row) : m_departureTime;
 }
 
 void JourneyResultItem::setDepartureTime(const QString &departureTime)
 {
-    m_departureTime = departureTime;
+    if (m_list)
+        m_list->setDepartureTime(m_row, departureTime);
+    else
+        m_departureTime = departureTime;
 }
 
 QString JourneyResultItem::arrivalTime() const
 {
-    return m_arrivalTime;
+    return m_list ? m_list->arrivalTime(m_row) : m_arrivalTime;
 }
 
 void JourneyResultItem::setArrivalTime(const QString &arrivalTime)
 {
-    m_arrivalTime = arrivalTime;
+    if (m_list)
+        m_list->setArrivalTime(m_row, arrivalTime);
+    else
+        m_arrivalTime = arrivalTime;
 }
 
 QString JourneyResultItem::trainType() const
 {
-    return m_trainType;
+    return m_list ? m_list->trainType(m_row) : m_trainType;
 }
 
 void JourneyResultItem::setTrainType(const QString &trainType)
 {
-    m_trainType = trainType;
+    if (m_list)
+        m_list->setTrainType(m_row, trainType);
+    else
+        m_trainType = trainType;
 }
 
 QString JourneyResultItem::duration() const
 {
-    return m_duration;
+    return m_list ? m_list->duration(m_row) : m_duration;
 }
 
 void JourneyResultItem::setDuration(const QString &duration)
 {
-    m_duration = duration;
+    if (m_list)
+        m_list->setDuration(m_row, duration);
+    else
+        m_duration = duration;
 }
 
 QString JourneyResultItem::transfers() const
 {
-    return m_transfers;
+    return m_list ? m_list->transfers(m_row) : m_transfers;
 }
 
 void JourneyResultItem::setTransfers(const QString &transfers)
 {
-    m_transfers = transfers;
+    if (m_list)
+        m_list->setTransfers(m_row, transfers);
+    else
+        m_transfers = transfers;
 }
 
 QString JourneyResultItem::miscInfo() const
 {
-    return m_miscInfo;
+    return m_list ? m_list->miscInfo(m_row) : m_miscInfo;
 }
 
 void JourneyResultItem::setMiscInfo(const QString &miscInfo)
 {
-    m_miscInfo = miscInfo;
+    if (m_list)
+        m_list->setMiscInfo(m_row, miscInfo);
+    else
+        m_miscInfo = miscInfo;
+}
+
+QDateTime JourneyResultItem::departureDateTime() const
+{
+    return m_list ? m_list->departureDateTime(m_row) : m_departureDateTime;
+}
+
+void JourneyResultItem::setDepartureDateTime(const QDateTime &departureDateTime)
+{
+    if (m_list)
+        m_list->setDepartureDateTime(m_row, departureDateTime);
+    else
+        m_departureDateTime = departureDateTime;
+}
+
+QDateTime JourneyResultItem::arrivalDateTime() const
+{
+    return m_list ? m_list->arrivalDateTime(m_row) : m_arrivalDateTime;
+}
+
+void JourneyResultItem::setArrivalDateTime(const QDateTime &arrivalDateTime)
+{
+    if (m_list)
+        m_list->setArrivalDateTime(m_row, arrivalDateTime);
+    else
+        m_arrivalDateTime = arrivalDateTime;
 }
 
 QString JourneyResultItem::internalData1() const
 {
-    return m_internalData1;
+    return m_list ? m_list->internalData1(m_row) : m_internalData1;
 }
 
 void JourneyResultItem::setInternalData1(const QString &internalData1)
 {
-    m_internalData1 = internalData1;
+    if (m_list)
+        m_list->setInternalData1(m_row, internalData1);
+    else
+        m_internalData1 = internalData1;
 }
 
 QString JourneyResultItem::internalData2() const
 {
-    return m_internalData2;
+    return m_list ? m_list->internalData2(m_row) : m_internalData2;
 }
 
 void JourneyResultItem::setInternalData2(const QString &internalData2)
 {
-    m_internalData2 = internalData2;
+    if (m_list)
+        m_list->setInternalData2(m_row, internalData2);
+    else
+        m_internalData2 = internalData2;
 }
 
 //------------- JourneyDetailResultList
@@ -252,6 +791,10 @@ JourneyDetailResultItem *JourneyDetailResultList::getItem(int index)
 
 void JourneyDetailResultList::appendItem(JourneyDetailResultItem *item)
 {
+    // The list owns its items, they go away together with it.
+    if (item->thread() != thread())
+        item->moveToThread(thread());
+    item->setParent(this);
     m_items.append(item);
 }
 
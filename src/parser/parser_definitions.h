@@ -22,7 +22,11 @@
 
 #include <QObject>
 #include <QDate>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
 #include <QVariant>
+#include <QVector>
 #include <QDebug>
 
 namespace FahrplanNS
@@ -57,6 +61,8 @@ public:
     bool operator <(const Station &other) const;
 };
 typedef QList<Station> StationsList;
+// Consistent with operator ==, only the id identifies a station.
+uint qHash(const Station &station);
 Q_DECLARE_METATYPE(Station)
 Q_DECLARE_METATYPE(StationsList)
 
@@ -78,6 +84,8 @@ typedef QList<TimetableEntry> TimetableEntriesList;
 Q_DECLARE_METATYPE(TimetableEntry)
 Q_DECLARE_METATYPE(TimetableEntriesList)
 
+class JourneyResultList;
+
 class JourneyResultItem : public QObject
 {
     Q_OBJECT
@@ -89,12 +97,15 @@ class JourneyResultItem : public QObject
     Q_PROPERTY(QString duration READ duration WRITE setDuration)
     Q_PROPERTY(QString transfers READ transfers WRITE setTransfers)
     Q_PROPERTY(QString miscInfo READ miscInfo WRITE setMiscInfo)
+    Q_PROPERTY(QDateTime departureDateTime READ departureDateTime WRITE setDepartureDateTime)
+    Q_PROPERTY(QDateTime arrivalDateTime READ arrivalDateTime WRITE setArrivalDateTime)
 
     //Some Internal Data fields, primarly to store additional data per backend, like the details url
     Q_PROPERTY(QString internalData1 READ internalData1 WRITE setInternalData1)
     Q_PROPERTY(QString internalData2 READ internalData2 WRITE setInternalData2)
 
     public:
+        explicit JourneyResultItem(QObject *parent = 0);
         QString id() const;
         void setId(const QString &);
         QDate date() const;
@@ -111,11 +122,20 @@ class JourneyResultItem : public QObject
         void setTransfers(const QString &);
         QString miscInfo() const;
         void setMiscInfo(const QString &);
+        // Optional, derived from date and the display times if not set
+        QDateTime departureDateTime() const;
+        void setDepartureDateTime(const QDateTime &);
+        QDateTime arrivalDateTime() const;
+        void setArrivalDateTime(const QDateTime &);
         QString internalData1() const;
         void setInternalData1(const QString &);
         QString internalData2() const;
         void setInternalData2(const QString &);
     private:
+        friend class JourneyResultList;
+        JourneyResultList *m_list;
+        int m_row;
+
         QString m_id;
         QDate m_date;
         QString m_departureTime;
@@ -124,6 +144,8 @@ class JourneyResultItem : public QObject
         QString m_duration;
         QString m_transfers;
         QString m_miscInfo;
+        QDateTime m_departureDateTime;
+        QDateTime m_arrivalDateTime;
         QString m_internalData1;
         QString m_internalData2;
 };
@@ -131,15 +153,32 @@ class JourneyResultItem : public QObject
 class JourneyResultList : public QObject
 {
     Q_OBJECT
-    Q_PROPERTY(qreal count READ itemcount)
+    Q_ENUMS(SortOrder)
+    Q_PROPERTY(qreal count READ itemcount NOTIFY viewChanged)
+    Q_PROPERTY(SortOrder sortOrder READ sortOrder WRITE setSortOrder NOTIFY viewChanged)
+    Q_PROPERTY(QStringList products READ products NOTIFY viewChanged)
+    Q_PROPERTY(QStringList productFilter READ productFilter WRITE setProductFilter NOTIFY viewChanged)
     Q_PROPERTY(QString departureStation READ departureStation WRITE setDepartureStation)
     Q_PROPERTY(QString viaStation READ viaStation WRITE setViaStation)
     Q_PROPERTY(QString arrivalStation READ arrivalStation WRITE setArrivalStation)
     Q_PROPERTY(QString timeInfo READ timeInfo WRITE setTimeInfo)
 
+    public:
+        enum SortOrder {
+            OriginalOrder,
+            DepartureOrder,
+            FastestOrder,
+            FewestTransfersOrder,
+            EarliestArrivalOrder
+        };
+
     public slots:
         JourneyResultItem *getItem(int);
+    signals:
+        void viewChanged();
     public:
+        explicit JourneyResultList(QObject *parent = 0);
+        // Copies the item into the list, the caller keeps ownership of it.
         void appendItem(JourneyResultItem *item);
         qreal itemcount();
         QString departureStation() const;
@@ -150,14 +189,102 @@ class JourneyResultList : public QObject
         void setViaStation(const QString &);
         QString timeInfo() const;
         void setTimeInfo(const QString &);
+
+        // Sorting and filtering only change which rows itemcount() and
+        // getItem() expose, and in which order. Journeys are kept if all
+        // their products are part of the filter, an empty filter keeps all.
+        SortOrder sortOrder() const;
+        void setSortOrder(SortOrder order);
+        QStringList products() const;
+        QStringList productFilter() const;
+        void setProductFilter(const QStringList &products);
+        // Row behind the visible index
+        int row(int index) const;
+
+        // Direct access to the rows, without creating item objects.
+        // The *Minutes() and transferCount() accessors return -1 if the
+        // backend delivered the value in an unusual format.
+        QString id(int row) const;
+        QDate date(int row) const;
+        QString departureTime(int row) const;
+        int departureMinutes(int row) const;
+        QString arrivalTime(int row) const;
+        int arrivalMinutes(int row) const;
+        QString trainType(int row) const;
+        QString duration(int row) const;
+        int durationMinutes(int row) const;
+        QString transfers(int row) const;
+        int transferCount(int row) const;
+        // Minutes since 1970-01-01 00:00 local time, -1 if unknown
+        int departureStamp(int row) const;
+        int arrivalStamp(int row) const;
+        QDateTime departureDateTime(int row) const;
+        QDateTime arrivalDateTime(int row) const;
+        QStringList products(int row) const;
+        QString miscInfo(int row) const;
+        QString internalData1(int row) const;
+        QString internalData2(int row) const;
     private:
-        QList<JourneyResultItem*> m_items;
+        friend class JourneyResultItem;
+
+        // One entry per journey in each column
+        QVector<QString> m_ids;
+        QVector<qint32> m_dates;
+        QVector<qint32> m_departureTimes;
+        QVector<qint32> m_arrivalTimes;
+        QVector<qint32> m_durations;
+        QVector<qint32> m_transfers;
+        QVector<qint32> m_trainTypes;
+        QVector<qint32> m_miscInfos;
+        QVector<qint32> m_departureStamps;
+        QVector<qint32> m_arrivalStamps;
+        QVector<quint32> m_products;
+        QVector<QString> m_internalData1;
+        QVector<QString> m_internalData2;
+
+        // Interned train types, infos and values in unusual formats
+        QStringList m_strings;
+        QHash<QString, qint32> m_stringIndex;
+
+        // Product of each bit in m_products
+        QStringList m_productNames;
+
+        // Visible rows, only used if sorted or filtered
+        QVector<int> m_view;
+        SortOrder m_sortOrder;
+        QStringList m_productFilter;
+
+        // Item objects for QML, created on demand
+        QVector<JourneyResultItem *> m_views;
+        QMutex m_viewsLock;
+
         QString m_departureStation;
         QString m_viaStation;
         QString m_arrivalStation;
         QString m_timeInfo;
-};
 
+        qint32 intern(const QString &text);
+        qint32 encodeTime(const QString &time);
+        qint32 encodeDuration(const QString &duration);
+        qint32 encodeCount(const QString &count);
+        QString decodeTime(qint32 value) const;
+        quint32 productMask(const QString &trainType);
+        void setStamps(int row, const QDateTime &departure, const QDateTime &arrival);
+        void updateView();
+
+        void setId(int row, const QString &);
+        void setDate(int row, const QDate &);
+        void setDepartureTime(int row, const QString &);
+        void setArrivalTime(int row, const QString &);
+        void setTrainType(int row, const QString &);
+        void setDuration(int row, const QString &);
+        void setTransfers(int row, const QString &);
+        void setMiscInfo(int row, const QString &);
+        void setDepartureDateTime(int row, const QDateTime &);
+        void setArrivalDateTime(int row, const QDateTime &);
+        void setInternalData1(int row, const QString &);
+        void setInternalData2(int row, const QString &);
+};
 
 class JourneyDetailResultItem : public QObject
 {
@@ -37,7 +37,7 @@ ParserDubaiEFA::ParserDubaiEFA(QObject *parent) :
 }
 
 
-QStringList ParserDubaiEFA::getTrainRestrictions()
+QStringList ParserDubaiEFA::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
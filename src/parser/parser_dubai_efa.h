@@ -30,10 +30,12 @@ public:
     explicit ParserDubaiEFA(QObject *parent = 0);
     static QString getName() { return QString("%1 (rta.ae)").arg(tr("Dubai")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "rta.ae"; }
+    static QString getShortName() { return "rta.ae"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 };
 
@@ -110,28 +110,8 @@ ParserEFA::ParserEFA(QObject *parent) :
     m_timeTableForStationParameters.isValid = false;
 }
 
-bool ParserEFA::supportsGps()
-{
-    return true;
-}
-
-bool ParserEFA::supportsVia()
-{
-    return true;
-}
-
-
-bool ParserEFA::supportsTimeTable()
-{
-    return true;
-}
-
-bool ParserEFA::supportsTimeTableDirection()
-{
-    return false;
-}
 
-QStringList ParserEFA::getTrainRestrictions()
+QStringList ParserEFA::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
@@ -417,6 +397,8 @@ void ParserEFA::searchJourney(const Station &departureStation, const Station &vi
     m_searchJourneyParameters.mode = mode;
     m_searchJourneyParameters.trainrestrictions = trainrestrictions;
 
+    m_tripContext.sessionID.clear();
+    m_tripContext.requestID.clear();
 
     currentRequestState = FahrplanNS::searchJourneyRequest;
     Q_UNUSED(viaStation);
@@ -511,23 +493,11 @@ void ParserEFA::searchJourney(const Station &departureStation, const Station &vi
 void ParserEFA::parseSearchJourney(QNetworkReply *networkReply)
 {
     qDebug() << "ParserEFA::parseSearchJourney(QNetworkReply *networkReply)";
-    lastJourneyResultList = new JourneyResultList();
-
-    for (QHash<QString, JourneyDetailResultList *>::Iterator it = cachedJourneyDetailsEfa.begin(); it != cachedJourneyDetailsEfa.end();) {
-        JourneyDetailResultList *jdrl = it.value();
-        it = cachedJourneyDetailsEfa.erase(it);
-        delete jdrl;
-    }
-
-    /// Use fallback values for empty results (i.e. no connections found)
-    lastJourneyResultList->setDepartureStation(m_searchJourneyParameters.departureStation.name);
-    lastJourneyResultList->setViaStation(m_searchJourneyParameters.viaStation.name);
-    lastJourneyResultList->setArrivalStation(m_searchJourneyParameters.arrivalStation.name);
-    //: DATE, TIME
-    lastJourneyResultList->setTimeInfo(tr("%1, %2", "DATE, TIME").arg(m_searchJourneyParameters.dateTime.date().toString(Qt::DefaultLocaleShortDate)).arg(m_searchJourneyParameters.dateTime.time().toString(Qt::DefaultLocaleShortDate)));
-
-    m_earliestArrival = m_latestResultDeparture = QDateTime();
+    parseJourneys(networkReply, FahrplanNS::searchJourneyRequest);
+}
 
+void ParserEFA::parseJourneys(QNetworkReply *networkReply, FahrplanNS::curReqStates requestState)
+{
     QDomDocument doc("mydocument");
     //(const QString & text, QString * errorMsg = 0, int * errorLine = 0, int * errorColumn = 0)
     QString errorMsg;
@@ -536,15 +506,56 @@ void ParserEFA::parseSearchJourney(QNetworkReply *networkReply)
     QByteArray data = readNetworkReply(networkReply);
     doc.setContent(data, &errorMsg, &errorLine, &errorColumn);
     //qDebug() << "errorMsg:" << errorMsg << ", errorLine:" << errorLine << ", errorColumn:" << errorColumn;
+
+    QDomElement requestElement = doc.firstChildElement("itdRequest");
     QDomNodeList routeList = doc.elementsByTagName("itdRoute");
 
+    // An expired server session answers continuations without trips. The
+    // current results stay, a new search from their times replaces them.
+    if (requestState != FahrplanNS::searchJourneyRequest && routeList.isEmpty()) {
+        qDebug() << "Trip session expired, searching by time";
+        m_tripContext.sessionID.clear();
+        m_tripContext.requestID.clear();
+        if (searchJourneyByTime(requestState))
+            return;
+    }
+
+    beginResultScope();
+    lastJourneyResultList = adoptResult(new JourneyResultList());
+
+    // The details belong to the result scope of their search.
+    cachedJourneyDetailsEfa.clear();
+
+    /// Use fallback values for empty results (i.e. no connections found)
+    lastJourneyResultList->setDepartureStation(m_searchJourneyParameters.departureStation.name);
+    lastJourneyResultList->setViaStation(m_searchJourneyParameters.viaStation.name);
+    lastJourneyResultList->setArrivalStation(m_searchJourneyParameters.arrivalStation.name);
+    //: DATE, TIME
+    lastJourneyResultList->setTimeInfo(tr("%1, %2", "DATE, TIME").arg(m_searchJourneyParameters.dateTime.date().toString(Qt::DefaultLocaleShortDate)).arg(m_searchJourneyParameters.dateTime.time().toString(Qt::DefaultLocaleShortDate)));
+
+    // The paging times are replaced once the trips are parsed, an expired
+    // continuation has used the previous ones above.
+    QDateTime earliestArrival, latestResultDeparture;
+
+    // The server keeps the trip calculation in a session, remember it so that
+    // later/earlier can page through it instead of starting a new search.
+    m_tripContext.sessionID = requestElement.attribute("sessionID");
+    m_tripContext.requestID = requestElement.firstChildElement("itdTripRequest").attribute("requestID");
+    if (m_tripContext.sessionID == "0" || m_tripContext.requestID.isEmpty()) {
+        m_tripContext.sessionID.clear();
+        m_tripContext.requestID.clear();
+    }
+
     int numberOfChanges = 0;
     QString duration;
 
     for(int nodeCounter = 0 ; nodeCounter < routeList.size() ; ++nodeCounter)  {
+        if (isCancelled())
+            return;
+
         /* Each node has the following attributes: "vehicleTime" "alternative" "method" "print" "individualDuration" "publicDuration" "active" "distance" "routeIndex" "cTime" "selected" "searchMode" "delete" "changes" */
         JourneyResultItem *item = new JourneyResultItem();
-        JourneyDetailResultList *detailsList = new JourneyDetailResultList();
+        JourneyDetailResultList *detailsList = adoptResult(new JourneyDetailResultList());
 
         numberOfChanges = routeList.at(nodeCounter).toElement().attribute("changes").toInt();
         duration = routeList.at(nodeCounter).toElement().attribute("publicDuration");
@@ -657,8 +668,8 @@ void ParserEFA::parseSearchJourney(QNetworkReply *networkReply)
         item->setTrainType(meansOfTransportNameList.join(", ").trimmed());
         item->setDepartureTime(departureDateTime.toString("hh:mm"));
         item->setArrivalTime(arrivalDateTime.toString("hh:mm"));
-
-        lastJourneyResultList->appendItem(item);
+        item->setDepartureDateTime(departureDateTime);
+        item->setArrivalDateTime(arrivalDateTime);
 
         detailsList->setId(QString::number(nodeCounter+1));
         detailsList->setDepartureStation(lastJourneyResultList->departureStation());
@@ -669,12 +680,17 @@ void ParserEFA::parseSearchJourney(QNetworkReply *networkReply)
         detailsList->setDepartureDateTime(departureDateTime);
         cachedJourneyDetailsEfa[QString::number(nodeCounter+1)] = detailsList;
 
-        if (!m_earliestArrival.isValid() || arrivalDateTime < m_earliestArrival)
-            m_earliestArrival = arrivalDateTime.addSecs(-60);
-        if (!m_latestResultDeparture.isValid() || departureDateTime > m_latestResultDeparture)
-            m_latestResultDeparture = departureDateTime.addSecs(60);
+        lastJourneyResultList->appendItem(item);
+        delete item;
+
+        if (!earliestArrival.isValid() || arrivalDateTime < earliestArrival)
+            earliestArrival = arrivalDateTime.addSecs(-60);
+        if (!latestResultDeparture.isValid() || departureDateTime > latestResultDeparture)
+            latestResultDeparture = departureDateTime.addSecs(60);
 
     }
+    m_earliestArrival = earliestArrival;
+    m_latestResultDeparture = latestResultDeparture;
     checkForError(&doc);
 
     emit journeyResult(lastJourneyResultList);
@@ -697,14 +713,11 @@ void ParserEFA::searchJourneyLater()
 {
     qDebug() << "ParserEFA::searchJourneyLater()";
 
-    if (m_latestResultDeparture.isValid())
-    {
-        qDebug() << "m_latestResultDeparture.isValid()";
-        searchJourney(m_searchJourneyParameters.departureStation, m_searchJourneyParameters.viaStation, m_searchJourneyParameters.arrivalStation, m_latestResultDeparture, Departure, 0);
-    }
-    else {
+    if (!m_tripContext.sessionID.isEmpty()) {
+        searchJourneyContinuation("tripNext", FahrplanNS::searchJourneyLaterRequest);
+    } else if (!searchJourneyByTime(FahrplanNS::searchJourneyLaterRequest)) {
         qDebug() << "!m_latestResultDeparture.isValid(), ";
-        JourneyResultList *journeyResultList = new JourneyResultList();
+        JourneyResultList *journeyResultList = adoptResult(new JourneyResultList());
         journeyResultList->setDepartureStation(m_searchJourneyParameters.departureStation.name);
         journeyResultList->setViaStation(m_searchJourneyParameters.viaStation.name);
         journeyResultList->setArrivalStation(m_searchJourneyParameters.arrivalStation.name);
@@ -717,10 +730,10 @@ void ParserEFA::searchJourneyLater()
 void ParserEFA::searchJourneyEarlier()
 {
     qDebug() << "ParserEFA::searchJourneyEarlier()";
-    if (m_earliestArrival.isValid())
-        searchJourney(m_searchJourneyParameters.departureStation, m_searchJourneyParameters.viaStation, m_searchJourneyParameters.arrivalStation, m_earliestArrival, Arrival, 0);
-    else {
-        JourneyResultList *journeyResultList = new JourneyResultList();
+    if (!m_tripContext.sessionID.isEmpty())
+        searchJourneyContinuation("tripPrev", FahrplanNS::searchJourneyEarlierRequest);
+    else if (!searchJourneyByTime(FahrplanNS::searchJourneyEarlierRequest)) {
+        JourneyResultList *journeyResultList = adoptResult(new JourneyResultList());
         journeyResultList->setDepartureStation(m_searchJourneyParameters.departureStation.name);
         journeyResultList->setViaStation(m_searchJourneyParameters.viaStation.name);
         journeyResultList->setArrivalStation(m_searchJourneyParameters.arrivalStation.name);
@@ -730,6 +743,67 @@ void ParserEFA::searchJourneyEarlier()
     }
 }
 
+void ParserEFA::searchJourneyContinuation(const QString &command, FahrplanNS::curReqStates requestState)
+{
+    qDebug() << "ParserEFA::searchJourneyContinuation(" << command << m_tripContext.sessionID << m_tripContext.requestID << ")";
+
+    if (currentRequestState != FahrplanNS::noneRequest)
+        return;
+    currentRequestState = requestState;
+
+    // Continues the trip calculation stored in the server session, the original
+    // stations, time and means of transport are kept by the server.
+    QUrl uri(baseRestUrl + QLatin1String("XML_TRIP_REQUEST2"));
+#if defined(BUILD_FOR_QT5)
+    QUrlQuery query;
+#else
+    QUrl query;
+#endif
+    query.addQueryItem("sessionID", m_tripContext.sessionID);
+    query.addQueryItem("requestID", m_tripContext.requestID);
+    query.addQueryItem("command", command);
+    query.addQueryItem("calcNumberOfTrips","5");
+    query.addQueryItem("language","en");
+    query.addQueryItem("coordOutputFormat","WGS84");
+    query.addQueryItem("coordListOutputFormat","STRING");
+    query.addQueryItem("coordOutputFormatTail","0");
+
+#if defined(BUILD_FOR_QT5)
+    uri.setQuery(query);
+#else
+    uri.setQueryItems(query.queryItems());
+#endif
+    sendHttpRequest(uri);
+
+    qDebug() << "query url:" << uri;
+}
+
+// Pages without the server session by searching again from the last known
+// departure or arrival. Returns false if no times are known yet.
+bool ParserEFA::searchJourneyByTime(FahrplanNS::curReqStates requestState)
+{
+    if (requestState == FahrplanNS::searchJourneyLaterRequest) {
+        if (!m_latestResultDeparture.isValid())
+            return false;
+        searchJourney(m_searchJourneyParameters.departureStation, m_searchJourneyParameters.viaStation, m_searchJourneyParameters.arrivalStation, m_latestResultDeparture, Departure, m_searchJourneyParameters.trainrestrictions);
+    } else {
+        if (!m_earliestArrival.isValid())
+            return false;
+        searchJourney(m_searchJourneyParameters.departureStation, m_searchJourneyParameters.viaStation, m_searchJourneyParameters.arrivalStation, m_earliestArrival, Arrival, m_searchJourneyParameters.trainrestrictions);
+    }
+    return true;
+}
+
+void ParserEFA::parseSearchLaterJourney(QNetworkReply *networkReply)
+{
+    parseJourneys(networkReply, FahrplanNS::searchJourneyLaterRequest);
+}
+
+void ParserEFA::parseSearchEarlierJourney(QNetworkReply *networkReply)
+{
+    parseJourneys(networkReply, FahrplanNS::searchJourneyEarlierRequest);
+}
+
 void ParserEFA::parseTimeTable(QNetworkReply *networkReply)
 {
     qDebug() << "ParserEFA::parseTimeTable(networkReply.url()=" << networkReply->url().toString() << ")";
@@ -31,7 +31,11 @@ public:
     explicit ParserEFA(QObject *parent = 0);
     static QString getName() { return "EFA"; }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return getName(); }
+    static QString getShortName() { return getName(); }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
+    static int getCapabilities() { return SupportsGps | SupportsVia | SupportsTimeTable; }
+    virtual int capabilities() { return getCapabilities(); }
 
 public slots:
     void findStationsByName(const QString &stationName);
@@ -41,21 +45,22 @@ public slots:
     void searchJourneyLater();
     void getJourneyDetails(const QString &id);
     void getTimeTableForStation(const Station &currentStation, const Station &, const QDateTime &dateTime, Mode mode, int);
-    bool supportsGps();
-    bool supportsVia();
-    bool supportsTimeTable();
-    bool supportsTimeTableDirection();
     void checkForError(QDomDocument *serverReplyDomDoc);
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 protected:
     QString baseRestUrl;
     void parseStationsByName(QNetworkReply *networkReply);
     void parseSearchJourney(QNetworkReply *networkReply);
+    void parseSearchLaterJourney(QNetworkReply *networkReply);
+    void parseSearchEarlierJourney(QNetworkReply *networkReply);
     void parseStationsByCoordinates(QNetworkReply *networkReply);
     void parseTimeTable(QNetworkReply *networkReply);
     QDateTime parseItdDateTime(const QDomElement &element);
     QByteArray readNetworkReply(QNetworkReply *networkReply);
+    void searchJourneyContinuation(const QString &command, FahrplanNS::curReqStates requestState);
+    void parseJourneys(QNetworkReply *networkReply, FahrplanNS::curReqStates requestState);
+    bool searchJourneyByTime(FahrplanNS::curReqStates requestState);
 
 private:
     JourneyResultList *lastJourneyResultList;
@@ -79,10 +84,13 @@ private:
         int trainrestrictions;
     } m_timeTableForStationParameters;
 
-    QDateTime m_earliestArrival, m_latestResultDeparture;
-
-
+    // Server side trip session, used for tripNext / tripPrev paging
+    struct {
+        QString sessionID;
+        QString requestID;
+    } m_tripContext;
 
+    QDateTime m_earliestArrival, m_latestResultDeparture;
 };
 
 #endif // PARSER_EFA_H
@@ -85,7 +85,8 @@ void ParserHafasBinary::searchJourney(const Station &departureStation, const Sta
 
 void ParserHafasBinary::parseSearchJourney(QNetworkReply *networkReply)
 {
-    lastJourneyResultList = new JourneyResultList();
+    beginResultScope();
+    lastJourneyResultList = adoptResult(new JourneyResultList());
     journeyDetailInlineData.clear();
     stringCache.clear();
 
@@ -239,6 +240,11 @@ void ParserHafasBinary::parseSearchJourney(QNetworkReply *networkReply)
         QMultiMap<QDateTime, JourneyResultItem*> journeyResultsByArrivalMap;
 
         for (int iConnection = 0; iConnection < numConnections; iConnection++) {
+            if (isCancelled()) {
+                qDeleteAll(journeyResultsByArrivalMap);
+                return;
+            }
+
             hafasData.device()->seek(0x4a + iConnection * 12);
             qint16 serviceDaysTableOffset;
             qint32 partsOffset;
@@ -324,7 +330,7 @@ void ParserHafasBinary::parseSearchJourney(QNetworkReply *networkReply)
             qDebug()<<"conId"<<connectionId;
             QStringList lineNames;
 
-            JourneyDetailResultList *inlineResults = new JourneyDetailResultList();
+            JourneyDetailResultList *inlineResults = adoptResult(new JourneyDetailResultList());
 
             for (int iPart = 0; iPart < numParts; iPart++) {
 
@@ -590,6 +596,8 @@ void ParserHafasBinary::parseSearchJourney(QNetworkReply *networkReply)
                 item->setArrivalTime(inlineResults
                                      ->getItem(inlineResults->itemcount() - 1)->arrivalDateTime()
                                      .time().toString(timeFormat));
+                item->setDepartureDateTime(inlineResults->getItem(0)->departureDateTime());
+                item->setArrivalDateTime(inlineResults->getItem(inlineResults->itemcount() - 1)->arrivalDateTime());
                 journeyResultsByArrivalMap.insert(inlineResults->getItem(inlineResults->itemcount() - 1)->arrivalDateTime(), item);
             }
         }
@@ -597,6 +605,7 @@ void ParserHafasBinary::parseSearchJourney(QNetworkReply *networkReply)
         QList<JourneyResultItem*> journeyResultsByArrivalList = journeyResultsByArrivalMap.values();
         Q_FOREACH(JourneyResultItem *item, journeyResultsByArrivalList) {
             lastJourneyResultList->appendItem(item);
+            delete item;
         }
 
         hafasContext.seqNr = QString::number(seqNr);
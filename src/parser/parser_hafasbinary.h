@@ -32,7 +32,8 @@ public:
 
     static QString getName() { return "HafasBinary"; }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return getName(); }
+    static QString getShortName() { return getName(); }
+    virtual QString shortName() { return getShortName(); }
 
     void searchJourney(const Station &departureStation, const Station &viaStation, const Station &arrivalStation, const QDateTime &dateTime, Mode mode, int trainrestrictions);
     void searchJourneyEarlier();
@@ -50,26 +50,6 @@ ParserHafasXml::ParserHafasXml(QObject *parent) :
      STTableMode = 0;
 }
 
-bool ParserHafasXml::supportsGps()
-{
-    return true;
-}
-
-bool ParserHafasXml::supportsVia()
-{
-    return true;
-}
-
-bool ParserHafasXml::supportsTimeTable()
-{
-    return true;
-}
-
-bool ParserHafasXml::supportsTimeTableDirection()
-{
-    return STTableMode == 0;
-}
-
 void ParserHafasXml::getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions)
 {
     if (currentRequestState != FahrplanNS::noneRequest) {
@@ -500,7 +480,7 @@ QString ParserHafasXml::getTrainRestrictionsCodes(int trainrestrictions)
     return trainrestr;
 }
 
-QStringList ParserHafasXml::getTrainRestrictions()
+QStringList ParserHafasXml::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
@@ -647,7 +627,8 @@ QString ParserHafasXml::parseExternalIds(const QVariant &id) const
 
 void ParserHafasXml::parseSearchJourney(QNetworkReply *networkReply)
 {
-    lastJourneyResultList = new JourneyResultList();
+    beginResultScope();
+    lastJourneyResultList = adoptResult(new JourneyResultList());
     journeyDetailInlineData.clear();
 
     QDomDocument doc;
@@ -656,6 +637,9 @@ void ParserHafasXml::parseSearchJourney(QNetworkReply *networkReply)
 
     const QDomNodeList connections = doc.elementsByTagName("Connection");
     for (int i = 0; i < connections.count(); ++i) {
+        if (isCancelled())
+            return;
+
         JourneyResultItem *item = new JourneyResultItem();
         item->setId(connections.at(i).toElement().attribute("id").trimmed());
 
@@ -682,6 +666,15 @@ void ParserHafasXml::parseSearchJourney(QNetworkReply *networkReply)
                                                            .attribute("name")
                                                            .trimmed());
 
+        item->setDepartureDateTime(cleanHafasDateTime(depStop.firstChildElement("Dep")
+                                                             .firstChildElement("Time")
+                                                             .text()
+                                                             .trimmed(), item->date()));
+        item->setArrivalDateTime(cleanHafasDateTime(arrStation.firstChildElement("Arr")
+                                                              .firstChildElement("Time")
+                                                              .text()
+                                                              .trimmed(), item->date()));
+
         item->setTransfers(overview.firstChildElement("Transfers").text().trimmed());
         item->setDuration(cleanHafasDate(overview.firstChildElement("Duration")
                                                  .firstChildElement("Time")
@@ -726,6 +719,7 @@ void ParserHafasXml::parseSearchJourney(QNetworkReply *networkReply)
         lastJourneyResultList->setTimeInfo(item->date().toString());
 
         lastJourneyResultList->appendItem(item);
+        delete item;
     }
 
     hafasContext.seqNr = doc.documentElement()
@@ -842,7 +836,7 @@ void ParserHafasXml::getJourneyDetails(const QString &id)
 
 JourneyDetailResultList* ParserHafasXml::internalParseJourneyDetails(const QDomElement &connection)
 {
-    JourneyDetailResultList *results = new JourneyDetailResultList();
+    JourneyDetailResultList *results = adoptResult(new JourneyDetailResultList());
 
     const QDomNodeList sections = connection.elementsByTagName("ConSection");
     for (int i = 0; i < sections.count(); ++i) {
@@ -59,7 +59,11 @@ public:
     explicit ParserHafasXml(QObject *parent = 0);
     static QString getName() { return "HafasXML"; }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return getName(); }
+    static QString getShortName() { return getName(); }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
+    static int getCapabilities() { return SupportsGps | SupportsVia | SupportsTimeTable | SupportsTimeTableDirection; }
+    virtual int capabilities() { return getCapabilities(); }
 
 public slots:
     void getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTime, ParserAbstract::Mode mode, int trainrestrictions);
@@ -69,11 +73,7 @@ public slots:
     void searchJourneyLater();
     void searchJourneyEarlier();
     void getJourneyDetails(const QString &id);
-    bool supportsGps();
-    bool supportsVia();
-    bool supportsTimeTable();
-    bool supportsTimeTableDirection();
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 protected:
     QString baseXmlUrl;
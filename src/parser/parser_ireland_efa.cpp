@@ -39,7 +39,7 @@ ParserIrelandEFA::ParserIrelandEFA(QObject *parent) :
 }
 
 
-QStringList ParserIrelandEFA::getTrainRestrictions()
+QStringList ParserIrelandEFA::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
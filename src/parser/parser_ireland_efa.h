@@ -30,10 +30,12 @@ public:
     explicit ParserIrelandEFA(QObject *parent = 0);
     static QString getName() { return QString("%1 (transportforireland.ie)").arg(tr("Ireland")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "transportforireland.ie"; }
+    static QString getShortName() { return "transportforireland.ie"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 };
 
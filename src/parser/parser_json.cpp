@@ -0,0 +1,480 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "parser_json.h"
+
+#include <cstring>
+
+// Replies are never nested this deep, it only protects the stack
+// against broken or hostile input.
+static const int maxJsonDepth = 256;
+
+//-------------- ParserJsonDocument
+
+ParserJsonDocument::ParserJsonDocument(const QByteArray &json)
+    : m_data(json)
+    , m_valid(false)
+{
+    int pos = 0;
+
+    // Skip UTF-8 byte order mark
+    if (m_data.startsWith("\xEF\xBB\xBF"))
+        pos = 3;
+
+    // Rough guess of the node count, avoids most reallocations
+    m_nodes.reserve(m_data.size() / 16 + 1);
+
+    skipWhitespace(pos);
+    if (parseValue(pos, 0) < 0) {
+        m_nodes.clear();
+        return;
+    }
+
+    skipWhitespace(pos);
+    if (pos != m_data.size()) {
+        m_error = QString("Unexpected data at offset %1").arg(pos);
+        m_nodes.clear();
+        return;
+    }
+
+    m_valid = true;
+}
+
+ParserJsonValue ParserJsonDocument::root() const
+{
+    if (!m_valid || m_nodes.isEmpty())
+        return ParserJsonValue();
+    return ParserJsonValue(this, 0);
+}
+
+void ParserJsonDocument::skipWhitespace(int &pos) const
+{
+    const char *data = m_data.constData();
+    const int size = m_data.size();
+    while (pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r'))
+        ++pos;
+}
+
+bool ParserJsonDocument::parseString(int &pos, int &start, int &length, bool &escaped)
+{
+    const char *data = m_data.constData();
+    const int size = m_data.size();
+
+    if (pos >= size || data[pos] != '"') {
+        m_error = QString("Expected string at offset %1").arg(pos);
+        return false;
+    }
+
+    ++pos;
+    start = pos;
+    escaped = false;
+    while (pos < size && data[pos] != '"') {
+        if (data[pos] == '\\') {
+            escaped = true;
+            ++pos;
+        }
+        ++pos;
+    }
+
+    if (pos >= size) {
+        m_error = QLatin1String("Unterminated string");
+        return false;
+    }
+
+    length = pos - start;
+    ++pos; // closing quote
+    return true;
+}
+
+int ParserJsonDocument::parseValue(int &pos, int depth)
+{
+    const char *data = m_data.constData();
+    const int size = m_data.size();
+
+    if (depth > maxJsonDepth) {
+        m_error = QLatin1String("Document too deeply nested");
+        return -1;
+    }
+    if (pos >= size) {
+        m_error = QLatin1String("Unexpected end of document");
+        return -1;
+    }
+
+    Node node;
+    node.type = ParserJsonValue::Null;
+    node.escaped = false;
+    node.keyEscaped = false;
+    node.start = pos;
+    node.length = 0;
+    node.keyStart = -1;
+    node.keyLength = 0;
+    node.next = -1;
+    node.count = 0;
+
+    const char c = data[pos];
+
+    if (c == '{' || c == '[') {
+        const bool isObject = (c == '{');
+        const char close = isObject ? '}' : ']';
+
+        // Children are appended after their parent, so refer to it by index
+        // only, the vector may reallocate while parsing them.
+        const int index = m_nodes.size();
+        node.type = isObject ? ParserJsonValue::Object : ParserJsonValue::Array;
+        m_nodes.append(node);
+
+        ++pos;
+        skipWhitespace(pos);
+        if (pos < size && data[pos] == close) {
+            ++pos;
+            return index;
+        }
+
+        int previous = -1;
+        int count = 0;
+        forever {
+            int keyStart = -1;
+            int keyLength = 0;
+            bool keyEscaped = false;
+            if (isObject) {
+                if (!parseString(pos, keyStart, keyLength, keyEscaped))
+                    return -1;
+                skipWhitespace(pos);
+                if (pos >= size || data[pos] != ':') {
+                    m_error = QString("Expected ':' at offset %1").arg(pos);
+                    return -1;
+                }
+                ++pos;
+                skipWhitespace(pos);
+            }
+
+            const int child = parseValue(pos, depth + 1);
+            if (child < 0)
+                return -1;
+
+            m_nodes[child].keyStart = keyStart;
+            m_nodes[child].keyLength = keyLength;
+            m_nodes[child].keyEscaped = keyEscaped;
+            if (previous >= 0)
+                m_nodes[previous].next = child;
+            previous = child;
+            ++count;
+
+            skipWhitespace(pos);
+            if (pos < size && data[pos] == ',') {
+                ++pos;
+                skipWhitespace(pos);
+                continue;
+            }
+            if (pos < size && data[pos] == close) {
+                ++pos;
+                break;
+            }
+            m_error = QString("Expected ',' or '%1' at offset %2").arg(close).arg(pos);
+            return -1;
+        }
+
+        m_nodes[index].count = count;
+        return index;
+    }
+
+    if (c == '"') {
+        int start;
+        int length;
+        bool escaped;
+        if (!parseString(pos, start, length, escaped))
+            return -1;
+        node.type = ParserJsonValue::String;
+        node.start = start;
+        node.length = length;
+        node.escaped = escaped;
+    } else if (c == 't' && size - pos >= 4 && qstrncmp(data + pos, "true", 4) == 0) {
+        node.type = ParserJsonValue::Bool;
+        node.length = 4;
+        pos += 4;
+    } else if (c == 'f' && size - pos >= 5 && qstrncmp(data + pos, "false", 5) == 0) {
+        node.type = ParserJsonValue::Bool;
+        node.length = 5;
+        pos += 5;
+    } else if (c == 'n' && size - pos >= 4 && qstrncmp(data + pos, "null", 4) == 0) {
+        node.type = ParserJsonValue::Null;
+        node.length = 4;
+        pos += 4;
+    } else {
+        while (pos < size && ((data[pos] >= '0' && data[pos] <= '9') || data[pos] == '-'
+                              || data[pos] == '+' || data[pos] == '.' || data[pos] == 'e' || data[pos] == 'E'))
+            ++pos;
+        node.length = pos - node.start;
+        if (node.length == 0) {
+            m_error = QString("Unexpected character at offset %1").arg(pos);
+            return -1;
+        }
+        node.type = ParserJsonValue::Number;
+    }
+
+    m_nodes.append(node);
+    return m_nodes.size() - 1;
+}
+
+QString ParserJsonDocument::decodeString(int start, int length, bool escaped) const
+{
+    const char *data = m_data.constData() + start;
+
+    if (!escaped)
+        return QString::fromUtf8(data, length);
+
+    QString result;
+    result.reserve(length);
+
+    int segmentStart = 0;
+    int i = 0;
+    while (i < length) {
+        if (data[i] != '\\') {
+            ++i;
+            continue;
+        }
+
+        if (i > segmentStart)
+            result.append(QString::fromUtf8(data + segmentStart, i - segmentStart));
+
+        ++i;
+        if (i >= length)
+            break;
+
+        switch (data[i]) {
+        case 'b': result.append(QChar('\b')); break;
+        case 'f': result.append(QChar('\f')); break;
+        case 'n': result.append(QChar('\n')); break;
+        case 'r': result.append(QChar('\r')); break;
+        case 't': result.append(QChar('\t')); break;
+        case 'u':
+            if (i + 4 < length) {
+                bool ok;
+                const ushort unicode = QByteArray::fromRawData(data + i + 1, 4).toUShort(&ok, 16);
+                if (ok) {
+                    // Surrogate pairs arrive as two escapes and end up as two UTF-16 units
+                    result.append(QChar(unicode));
+                    i += 4;
+                }
+            }
+            break;
+        default:
+            // \" \\ \/ and anything unknown map to the character itself
+            result.append(QChar::fromLatin1(data[i]));
+            break;
+        }
+        ++i;
+        segmentStart = i;
+    }
+
+    if (segmentStart < length)
+        result.append(QString::fromUtf8(data + segmentStart, length - segmentStart));
+
+    return result;
+}
+
+bool ParserJsonDocument::keyEquals(const Node &node, const char *key) const
+{
+    if (node.keyStart < 0)
+        return false;
+
+    if (node.keyEscaped)
+        return decodeString(node.keyStart, node.keyLength, true) == QString::fromUtf8(key);
+
+    const int keyLength = qstrlen(key);
+    return keyLength == node.keyLength
+            && memcmp(m_data.constData() + node.keyStart, key, keyLength) == 0;
+}
+
+//-------------- ParserJsonValue
+
+ParserJsonValue::ParserJsonValue()
+    : m_doc(0)
+    , m_index(-1)
+{}
+
+ParserJsonValue::ParserJsonValue(const ParserJsonDocument *doc, int index)
+    : m_doc(doc)
+    , m_index(index)
+{}
+
+ParserJsonValue::Type ParserJsonValue::type() const
+{
+    if (!m_doc)
+        return Invalid;
+    return static_cast<Type>(m_doc->m_nodes.at(m_index).type);
+}
+
+int ParserJsonValue::count() const
+{
+    if (!m_doc)
+        return 0;
+    return m_doc->m_nodes.at(m_index).count;
+}
+
+bool ParserJsonValue::contains(const char *key) const
+{
+    return value(key).isValid();
+}
+
+ParserJsonValue ParserJsonValue::value(const char *key) const
+{
+    if (type() != Object)
+        return ParserJsonValue();
+
+    for (ParserJsonValue child = first(); child.isValid(); child = child.next()) {
+        if (m_doc->keyEquals(m_doc->m_nodes.at(child.m_index), key))
+            return child;
+    }
+    return ParserJsonValue();
+}
+
+ParserJsonValue ParserJsonValue::at(int index) const
+{
+    if (index < 0 || index >= count())
+        return ParserJsonValue();
+
+    ParserJsonValue child = first();
+    for (int i = 0; i < index; ++i)
+        child = child.next();
+    return child;
+}
+
+ParserJsonValue ParserJsonValue::first() const
+{
+    if (count() == 0)
+        return ParserJsonValue();
+    // Pre-order layout, the first child directly follows its parent
+    return ParserJsonValue(m_doc, m_index + 1);
+}
+
+ParserJsonValue ParserJsonValue::last() const
+{
+    return at(count() - 1);
+}
+
+ParserJsonValue ParserJsonValue::next() const
+{
+    if (!m_doc)
+        return ParserJsonValue();
+
+    const int next = m_doc->m_nodes.at(m_index).next;
+    if (next < 0)
+        return ParserJsonValue();
+    return ParserJsonValue(m_doc, next);
+}
+
+QString ParserJsonValue::key() const
+{
+    if (!m_doc)
+        return QString();
+
+    const ParserJsonDocument::Node &node = m_doc->m_nodes.at(m_index);
+    if (node.keyStart < 0)
+        return QString();
+    return m_doc->decodeString(node.keyStart, node.keyLength, node.keyEscaped);
+}
+
+QString ParserJsonValue::toString() const
+{
+    if (!m_doc)
+        return QString();
+
+    const ParserJsonDocument::Node &node = m_doc->m_nodes.at(m_index);
+    switch (node.type) {
+    case String:
+        return m_doc->decodeString(node.start, node.length, node.escaped);
+    case Number:
+    case Bool:
+        return QString::fromLatin1(m_doc->m_data.constData() + node.start, node.length);
+    default:
+        return QString();
+    }
+}
+
+double ParserJsonValue::toDouble(bool *ok) const
+{
+    if (ok)
+        *ok = false;
+    if (!m_doc)
+        return 0;
+
+    const ParserJsonDocument::Node &node = m_doc->m_nodes.at(m_index);
+    switch (node.type) {
+    case Number:
+        return QByteArray::fromRawData(m_doc->m_data.constData() + node.start, node.length).toDouble(ok);
+    case String:
+        return toString().toDouble(ok);
+    case Bool:
+        if (ok)
+            *ok = true;
+        return toBool() ? 1 : 0;
+    default:
+        return 0;
+    }
+}
+
+int ParserJsonValue::toInt(bool *ok) const
+{
+    if (ok)
+        *ok = false;
+    if (!m_doc)
+        return 0;
+
+    const ParserJsonDocument::Node &node = m_doc->m_nodes.at(m_index);
+    switch (node.type) {
+    case Number: {
+        bool isInt;
+        int result = QByteArray::fromRawData(m_doc->m_data.constData() + node.start, node.length).toInt(&isInt);
+        if (!isInt)
+            result = static_cast<int>(toDouble(&isInt));
+        if (ok)
+            *ok = isInt;
+        return result;
+    }
+    case String:
+        return toString().toInt(ok);
+    case Bool:
+        if (ok)
+            *ok = true;
+        return toBool() ? 1 : 0;
+    default:
+        return 0;
+    }
+}
+
+bool ParserJsonValue::toBool() const
+{
+    if (!m_doc)
+        return false;
+
+    const ParserJsonDocument::Node &node = m_doc->m_nodes.at(m_index);
+    switch (node.type) {
+    case Bool:
+        return m_doc->m_data.at(node.start) == 't';
+    case Number:
+        return toDouble() != 0;
+    case String: {
+        const QString str = toString();
+        return !str.isEmpty() && str != "0" && str != "false";
+    }
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef PARSER_JSON_H
+#define PARSER_JSON_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class ParserJsonDocument;
+
+/**
+ * @brief Lightweight handle to a value inside a ParserJsonDocument.
+ * Handles are cheap to copy and only valid as long as the document lives.
+ * Looking up a missing key or index returns an invalid handle, which
+ * behaves like a null value, so lookups can be chained safely.
+ */
+class ParserJsonValue
+{
+public:
+    enum Type { Invalid, Null, Bool, Number, String, Array, Object };
+
+    ParserJsonValue();
+
+    Type type() const;
+    bool isValid() const { return m_doc != 0; }
+    bool isNull() const { return type() == Null || type() == Invalid; }
+    bool isArray() const { return type() == Array; }
+    bool isObject() const { return type() == Object; }
+    bool isString() const { return type() == String; }
+
+    // Number of members / elements, 0 for scalars
+    int count() const;
+    bool contains(const char *key) const;
+    ParserJsonValue value(const char *key) const;
+    ParserJsonValue operator[](const char *key) const { return value(key); }
+    ParserJsonValue at(int index) const;
+    ParserJsonValue first() const;
+    ParserJsonValue last() const;
+    // Next member / element of the parent container
+    ParserJsonValue next() const;
+    QString key() const;
+
+    // Conversions follow QVariant semantics: strings holding numbers convert
+    // to numbers and numbers convert to their textual representation.
+    QString toString() const;
+    double toDouble(bool *ok = 0) const;
+    int toInt(bool *ok = 0) const;
+    bool toBool() const;
+
+private:
+    friend class ParserJsonDocument;
+    ParserJsonValue(const ParserJsonDocument *doc, int index);
+
+    const ParserJsonDocument *m_doc;
+    int m_index;
+};
+
+/**
+ * @brief Compact JSON DOM used by the JSON based backends.
+ * The whole reply is tokenized once into a flat node array which only
+ * references the raw bytes. Strings and numbers are only converted when
+ * they are read, so no intermediate QVariant tree is built.
+ */
+class ParserJsonDocument
+{
+public:
+    explicit ParserJsonDocument(const QByteArray &json);
+
+    bool isValid() const { return m_valid; }
+    QString errorString() const { return m_error; }
+    ParserJsonValue root() const;
+
+private:
+    Q_DISABLE_COPY(ParserJsonDocument)
+    friend class ParserJsonValue;
+
+    struct Node
+    {
+        quint8 type;
+        bool escaped;
+        bool keyEscaped;
+        int start;
+        int length;
+        int keyStart;
+        int keyLength;
+        int next;
+        int count;
+    };
+
+    QByteArray m_data;
+    QVector<Node> m_nodes;
+    bool m_valid;
+    QString m_error;
+
+    int parseValue(int &pos, int depth);
+    bool parseString(int &pos, int &start, int &length, bool &escaped);
+    void skipWhitespace(int &pos) const;
+    QString decodeString(int start, int length, bool escaped) const;
+    bool keyEquals(const Node &node, const char *key) const;
+};
+
+#endif // PARSER_JSON_H
@@ -29,7 +29,7 @@ ParserMobileBahnDe::ParserMobileBahnDe(QObject *parent) :
      STTableMode = 1;
 }
 
-QStringList ParserMobileBahnDe::getTrainRestrictions()
+QStringList ParserMobileBahnDe::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
@@ -34,10 +34,15 @@ public:
     explicit ParserMobileBahnDe(QObject *parent = 0);
     static QString getName() { return QString("%1 (bahn.de)").arg(tr("Germany")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "bahn.de"; }
+    static QString getShortName() { return "bahn.de"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
+    // STTableMode 1 can not filter by direction.
+    static int getCapabilities() { return SupportsGps | SupportsVia | SupportsTimeTable; }
+    virtual int capabilities() { return getCapabilities(); }
 
 public slots:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 protected:
 private:
@@ -32,7 +32,7 @@ ParserMunichEFA::ParserMunichEFA(QObject *parent) :
     acceptEncoding = "gzip";
 }
 
-QStringList ParserMunichEFA::getTrainRestrictions()
+QStringList ParserMunichEFA::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
@@ -30,10 +30,12 @@ public:
     explicit ParserMunichEFA(QObject *parent = 0);
     static QString getName() { return QString("%1, %2 (mvv-muenchen.de)").arg(tr("Germany"), tr("Munich")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "mvv-muenchen.de"; }
+    static QString getShortName() { return "mvv-muenchen.de"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 };
 
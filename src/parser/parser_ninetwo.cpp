@@ -18,6 +18,7 @@
 ****************************************************************************/
 
 #include "parser_ninetwo.h"
+#include "parser_json.h"
 
 #include <QUrl>
 #include <QNetworkReply>
@@ -159,7 +160,7 @@ void ParserNinetwo::getJourneyDetails(const QString &id)
         emit journeyDetailsResult(cachedResults.value(id));
 }
 
-QStringList ParserNinetwo::getTrainRestrictions()
+QStringList ParserNinetwo::getTrainRestrictionList()
 {
  QStringList restrictions;
  restrictions << tr("All");
@@ -174,20 +175,16 @@ void ParserNinetwo::parseTimeTable(QNetworkReply *networkReply)
     QByteArray allData = networkReply->readAll();
     qDebug() << "REPLY:>>>>>>>>>>>>\n" << allData;
 
-    QVariantMap doc = parseJson(allData);
-    if (doc.isEmpty()) {
+    ParserJsonDocument doc(allData);
+    if (!doc.root().isObject() || doc.root().count() == 0) {
         emit errorOccured(tr("Cannot parse reply from the server"));
         return;
     }
 
-    QVariantList tabs = doc.value("tabs").toList();
-    QString currentStation(doc.value("location").toMap().value("name").toString());
+    QString currentStation(doc.root()["location"]["name"].toString());
 
-    QVariantList::const_iterator i;
-    for (i = tabs.constBegin(); i != tabs.constEnd(); ++i) {
-        QVariantMap tab = i->toMap();
-        QString type = tab.value("id").toString();
-        QVariantList departures = tab.value("departures").toList();
+    for (ParserJsonValue tab = doc.root()["tabs"].first(); tab.isValid(); tab = tab.next()) {
+        QString type = tab["id"].toString();
         switch(timetableRestrictions){
             case all:
             default:
@@ -202,26 +199,24 @@ void ParserNinetwo::parseTimeTable(QNetworkReply *networkReply)
             break;
         }
 
-        QVariantList::const_iterator j;
-        for (j = departures.constBegin(); j != departures.constEnd(); ++j) {
-            QVariantMap departure = j->toMap();
+        for (ParserJsonValue departure = tab["departures"].first(); departure.isValid(); departure = departure.next()) {
             TimetableEntry entry;
             entry.currentStation=currentStation;
-            entry.destinationStation = departure.value("destinationName").toString();
-            entry.time = QTime::fromString(departure.value("time").toString(), "HH:mm");
-            QString via(departure.value("viaNames").toString());
+            entry.destinationStation = departure["destinationName"].toString();
+            entry.time = QTime::fromString(departure["time"].toString(), "HH:mm");
+            QString via(departure["viaNames"].toString());
             if (via != "" && !via.isNull())
                 via = tr("via %1");
-            QString remark(departure.value("remark").toString());
-            if (departure.value("realtimeState").toString() == "late") { //it is delayed
-                QString rtMessage(departure.value("realtimeText").toString());
+            QString remark(departure["remark"].toString());
+            if (departure["realtimeState"].toString() == "late") { //it is delayed
+                QString rtMessage(departure["realtimeText"].toString());
                 entry.miscInfo=QString(tr("(%1) %2 \n%3").arg(rtMessage, via, remark)).trimmed();
             }
             else
                 entry.miscInfo=QString("%1 %2").arg(via, remark).trimmed();
 
-            entry.platform = departure.value("platform").toString();
-            entry.trainType = departure.value("mode").toMap().value("name").toString();
+            entry.platform = departure["platform"].toString();
+            entry.trainType = departure["mode"]["name"].toString();
             result.append(entry);
         }
     }
@@ -235,28 +230,24 @@ void ParserNinetwo::parseStationsByName(QNetworkReply *networkReply)
     QByteArray allData = networkReply->readAll();
 //    qDebug() << "REPLY:>>>>>>>>>>>>\n" << allData;
 
-    QVariantMap doc = parseJson(allData);
-    if (doc.isEmpty()) {
+    ParserJsonDocument doc(allData);
+    if (!doc.root().isObject() || doc.root().count() == 0) {
         emit errorOccured(tr("Cannot parse reply from the server"));
         return;
     }
 
-    QVariantList stations = doc.value("locations").toList();
-
     StationsList result;
 
-    QVariantList::const_iterator i;
-    for (i = stations.constBegin(); i != stations.constEnd(); ++i) {
-        QVariantMap station = i->toMap();
+    for (ParserJsonValue station = doc.root()["locations"].first(); station.isValid(); station = station.next()) {
         Station s;
-        s.latitude = station.value("latLong").toMap().value("lat").toDouble();
-        s.longitude = station.value("latLong").toMap().value("long").toDouble();
-        //s.name=QString("[%1]%2").arg(station.value("type").toString(), station.value("name").toString());
-        s.name = station.value("name").toString();
-        s.miscInfo = station.value("type").toString();
-        if (station.value("type").toString() == "address")
-            s.name = s.name + " " + station.value("houseNr").toString();
-        s.id = station.value("id").toString();
+        s.latitude = station["latLong"]["lat"].toDouble();
+        s.longitude = station["latLong"]["long"].toDouble();
+        //s.name=QString("[%1]%2").arg(station["type"].toString(), station["name"].toString());
+        s.name = station["name"].toString();
+        s.miscInfo = station["type"].toString();
+        if (station["type"].toString() == "address")
+            s.name = s.name + " " + station["houseNr"].toString();
+        s.id = station["id"].toString();
         result.append(s);
     }
 
@@ -274,42 +265,42 @@ void ParserNinetwo::parseSearchJourney(QNetworkReply *networkReply)
     QByteArray allData = networkReply->readAll();
     qDebug() << "REPLY:>>>>>>>>>>>>\n" << allData;
 
-    QVariantMap doc = parseJson(allData);
-    if (doc.isEmpty()) {
+    ParserJsonDocument doc(allData);
+    if (!doc.root().isObject() || doc.root().count() == 0) {
         emit errorOccured(tr("Cannot parse reply from the server"));
         return;
     }
 
-    QVariantList journeys = doc.value("journeys").toList();
+    ParserJsonValue journeys = doc.root()["journeys"];
+
+    beginResultScope();
+    cachedResults.clear();
 
-    JourneyResultList* result=new JourneyResultList;
+    JourneyResultList* result = adoptResult(new JourneyResultList);
 
     QDateTime arrival;
     QDateTime departure;
 
-    QVariantList::const_iterator i;
-    for (i = journeys.constBegin(); i != journeys.constEnd(); ++i) {
-        QVariantMap journey = i->toMap();
+    for (ParserJsonValue journey = journeys.first(); journey.isValid(); journey = journey.next()) {
         parseJourneyOption(journey);
         JourneyResultItem* item = new JourneyResultItem;
-        arrival = QDateTime::fromString(journey.value("arrival").toString(), "yyyy-MM-ddTHH:mm");
-        departure = QDateTime::fromString(journey.value("departure").toString(),
+        arrival = QDateTime::fromString(journey["arrival"].toString(), "yyyy-MM-ddTHH:mm");
+        departure = QDateTime::fromString(journey["departure"].toString(),
                                           "yyyy-MM-ddTHH:mm");
-        if (i == journeys.constBegin())
+        if (result->itemcount() == 0)
             lastsearch.firstOption=departure;
 
         item->setArrivalTime(arrival.toString("HH:mm"));
         item->setDepartureTime(departure.toString("HH:mm"));
+        item->setArrivalDateTime(arrival);
+        item->setDepartureDateTime(departure);
 
-        QVariantList legs = journey.value("legs").toList();
         QStringList trains;
 
-        QVariantList::const_iterator j;
-        for (j = legs.constBegin(); j != legs.constEnd(); ++j)
+        for (ParserJsonValue leg = journey["legs"].first(); leg.isValid(); leg = leg.next())
         {
-            QVariantMap leg = j->toMap();
-            QString typeName = leg.value("mode").toMap().value("name").toString();
-            QString type = leg.value("mode").toMap().value("type").toString();
+            QString typeName = leg["mode"]["name"].toString();
+            QString type = leg["mode"]["type"].toString();
 
             if(type=="bus" || type=="tram" || type=="train" || type=="subway"){
                 if (typeName.length() > 0) {
@@ -321,10 +312,10 @@ void ParserNinetwo::parseSearchJourney(QNetworkReply *networkReply)
         trains.removeDuplicates();
 
         item->setTrainType(trains.join(", ").trimmed());
-        item->setTransfers(QString::number((int) journey.value("numberOfChanges").toDouble()));
+        item->setTransfers(QString::number((int) journey["numberOfChanges"].toDouble()));
         int minutes = departure.secsTo(arrival)/60;
         item->setDuration(QString("%1:%2").arg(minutes/60).arg(minutes%60,2,10,QChar('0')));
-        item->setId(journey.value("id").toString());
+        item->setId(journey["id"].toString());
         result->appendItem(item);
 
         //Set result metadata based on first result
@@ -333,6 +324,7 @@ void ParserNinetwo::parseSearchJourney(QNetworkReply *networkReply)
             result->setDepartureStation(cachedResults[item->id()]->departureStation());
             result->setArrivalStation(cachedResults[item->id()]->arrivalStation());
         }
+        delete item;
     }
     lastsearch.lastOption=departure;
     emit journeyResult(result);
@@ -353,15 +345,14 @@ void ParserNinetwo::parseJourneyDetails(QNetworkReply *)
     //should never happen
 }
 
-void ParserNinetwo::parseJourneyOption(const QVariantMap &object)
+void ParserNinetwo::parseJourneyOption(const ParserJsonValue &object)
 {
-    JourneyDetailResultList* result = new JourneyDetailResultList;
-    QString id = object.value("id").toString();
-    QVariantList legs = object.value("legs").toList();
+    JourneyDetailResultList* result = adoptResult(new JourneyDetailResultList);
+    QString id = object["id"].toString();
 
-    QDateTime arrival = QDateTime::fromString(object.value("arrival").toString(),
+    QDateTime arrival = QDateTime::fromString(object["arrival"].toString(),
                                               "yyyy-MM-ddTHH:mm");
-    QDateTime departure = QDateTime::fromString(object.value("departure").toString(),
+    QDateTime departure = QDateTime::fromString(object["departure"].toString(),
                                                 "yyyy-MM-ddTHH:mm");
     result->setArrivalDateTime(arrival);
     result->setDepartureDateTime(departure);
@@ -370,32 +361,31 @@ void ParserNinetwo::parseJourneyOption(const QVariantMap &object)
     minutes=minutes%60;
     result->setDuration(QString("%1:%2").arg(hours).arg(minutes, 2, 10, QChar('0')));
     result->setId(id);
-    for(int i = 0; i < legs.count(); i++)
+    for (ParserJsonValue leg = object["legs"].first(); leg.isValid(); leg = leg.next())
     {
-        QVariantMap leg = legs.at(i).toMap();
         JourneyDetailResultItem* resultItem = new JourneyDetailResultItem;
 
 
-        QVariantList stops = leg.value("stops").toList();
-        QVariantMap firstStop = stops[0].toMap();
-        QVariantMap lastStop = stops[stops.size()-1].toMap();
-        QVariantMap firstLocation = firstStop.value("location").toMap();
-        QVariantMap lastLocation = lastStop.value("location").toMap();
+        ParserJsonValue stops = leg["stops"];
+        ParserJsonValue firstStop = stops.first();
+        ParserJsonValue lastStop = stops.last();
+        ParserJsonValue firstLocation = firstStop["location"];
+        ParserJsonValue lastLocation = lastStop["location"];
 
 
-        resultItem->setArrivalStation(lastLocation.value("name").toString());
-        resultItem->setDepartureStation(firstLocation.value("name").toString());
+        resultItem->setArrivalStation(lastLocation["name"].toString());
+        resultItem->setDepartureStation(firstLocation["name"].toString());
 
-        QDateTime stopDeparture = QDateTime::fromString(firstStop.value("departure").toString(),
+        QDateTime stopDeparture = QDateTime::fromString(firstStop["departure"].toString(),
                                                         "yyyy-MM-ddTHH:mm");
-        QDateTime stopArrival = QDateTime::fromString(lastStop.value("arrival").toString(),
+        QDateTime stopArrival = QDateTime::fromString(lastStop["arrival"].toString(),
                                                       "yyyy-MM-ddTHH:mm");
 
         resultItem->setDepartureDateTime(stopDeparture);
         resultItem->setArrivalDateTime(stopArrival);
 
-        QString type = leg.value("mode").toMap().value("type").toString();
-        QString typeName = leg.value("mode").toMap().value("name").toString();
+        QString type = leg["mode"]["type"].toString();
+        QString typeName = leg["mode"]["name"].toString();
 
         //Fallback if typeName is empty
         if (typeName.length() == 0) {
@@ -403,15 +393,15 @@ void ParserNinetwo::parseJourneyOption(const QVariantMap &object)
         }
 
         if(type=="bus" || type=="tram" || type=="train" || type=="subway"){
-            if (firstStop.value("platform").toString().length() > 0) {
+            if (firstStop["platform"].toString().length() > 0) {
                 resultItem->setDepartureInfo(tr("Pl. %1")
-                                             .arg(firstStop.value("platform").toString()));
+                                             .arg(firstStop["platform"].toString()));
             }
-            if (lastStop.value("platform").toString() > 0) {
-                resultItem->setArrivalInfo(tr("Pl. %1").arg(lastStop.value("platform").toString()));
+            if (lastStop["platform"].toString().length() > 0) {
+                resultItem->setArrivalInfo(tr("Pl. %1").arg(lastStop["platform"].toString()));
             }
             resultItem->setTrain(typeName);
-            resultItem->setDirection(leg.value("destination").toString());
+            resultItem->setDirection(leg["destination"].toString());
         }
         else{
             resultItem->setTrain(type);
@@ -420,8 +410,10 @@ void ParserNinetwo::parseJourneyOption(const QVariantMap &object)
         result->appendItem(resultItem);
     }
 
-    result->setDepartureStation(result->getItem(0)->departureStation());
-    result->setArrivalStation(result->getItem(result->itemcount() - 1)->arrivalStation());
+    if (result->itemcount() > 0) {
+        result->setDepartureStation(result->getItem(0)->departureStation());
+        result->setArrivalStation(result->getItem(result->itemcount() - 1)->arrivalStation());
+    }
 
     cachedResults.insert(id, result);
 }
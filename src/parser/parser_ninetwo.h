@@ -25,6 +25,7 @@
 #include <QMap>
 
 class QNetworkReply;
+class ParserJsonValue;
 /**
  * @brief The ParserNinetwo class
  * Parser for the 9292ov.nl dutch public transport route planner backend.
@@ -59,7 +60,11 @@ public:
 public:
     static QString getName() { return QString("%1 / %2 (9292ov.nl)").arg(tr("Netherlands"), tr("Belgium")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "9292ov.nl"; }
+    static QString getShortName() { return "9292ov.nl"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
+    static int getCapabilities() { return SupportsGps | SupportsVia | SupportsTimeTable; }
+    virtual int capabilities() { return getCapabilities(); }
 
 public slots:
     void getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTtime, ParserAbstract::Mode mode, int trainrestrictions);
@@ -69,11 +74,7 @@ public slots:
     void searchJourneyLater();
     void searchJourneyEarlier();
     void getJourneyDetails(const QString &id);
-    bool supportsGps() { return true; }
-    bool supportsVia() { return true; }
-    bool supportsTimeTable() { return true; }
-    bool supportsTimeTableDirection() { return false; }
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 protected:
     void parseTimeTable(QNetworkReply *networkReply);
@@ -86,7 +87,7 @@ protected:
     QMap<QString, JourneyDetailResultList*> cachedResults;
 
 private:
-    void parseJourneyOption(const QVariantMap &object);
+    void parseJourneyOption(const ParserJsonValue &object);
 };
 
 #endif // PARSER_NINETWO_H
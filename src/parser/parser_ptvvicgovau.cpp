@@ -40,7 +40,7 @@ ParserPTVVicGovAu::ParserPTVVicGovAu(QObject *parent) :
 }
 
 
-QStringList ParserPTVVicGovAu::getTrainRestrictions()
+QStringList ParserPTVVicGovAu::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
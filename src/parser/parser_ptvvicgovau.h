@@ -30,10 +30,12 @@ public:
     explicit ParserPTVVicGovAu(QObject *parent = 0);
     static QString getName() { return QString("%1, %2 (ptv.vic.gov.au)").arg(tr("Australia"), tr("Victoria")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "ptv.vic.gov.au"; }
+    static QString getShortName() { return "ptv.vic.gov.au"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 };
 
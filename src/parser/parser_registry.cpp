@@ -0,0 +1,164 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "parser_registry.h"
+
+#ifdef FAHRPLAN_BACKEND_MOBILEBAHNDE
+#include "parser_mobilebahnde.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLOEBBAT
+#include "parser_xmloebbat.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLREJSEPLANENDK
+#include "parser_xmlrejseplanendk.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLSBBCH
+#include "parser_xmlsbbch.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLNRI
+#include "parser_xmlnri.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLVASTTRAFIKSE
+#include "parser_xmlvasttrafikse.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_PTVVICGOVAU
+#include "parser_ptvvicgovau.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_SYDNEY_EFA
+#include "parser_sydney_efa.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_SF_BAY_EFA
+#include "parser_sf_bay_efa.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_IRELAND_EFA
+#include "parser_ireland_efa.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_DUBAI_EFA
+#include "parser_dubai_efa.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_NINETWO
+#include "parser_ninetwo.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_MUNICH_EFA
+#include "parser_munich_efa.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_SALZBURG_EFA
+#include "parser_salzburg_efa.h"
+#endif
+#ifdef FAHRPLAN_BACKEND_RESROBOT
+#include "parser_resrobot.h"
+#endif
+
+static QList<ParserInfo> buildBackendList()
+{
+    QList<ParserInfo> list;
+
+    // The order defines the indexes, new backends go to the end.
+#ifdef FAHRPLAN_BACKEND_MOBILEBAHNDE
+    list << parserInfo<ParserMobileBahnDe>();
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLOEBBAT
+    list << parserInfo<ParserXmlOebbAt>();
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLREJSEPLANENDK
+    list << parserInfo<ParserXmlRejseplanenDk>();
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLSBBCH
+    list << parserInfo<ParserXmlSbbCh>();
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLNRI
+    list << parserInfo<ParserXmlNri>();
+#endif
+#ifdef FAHRPLAN_BACKEND_XMLVASTTRAFIKSE
+    list << parserInfo<ParserXmlVasttrafikSe>();
+#endif
+#ifdef FAHRPLAN_BACKEND_PTVVICGOVAU
+    list << parserInfo<ParserPTVVicGovAu>();
+#endif
+#ifdef FAHRPLAN_BACKEND_SYDNEY_EFA
+    list << parserInfo<ParserSydneyEFA>();
+#endif
+#ifdef FAHRPLAN_BACKEND_SF_BAY_EFA
+    list << parserInfo<ParserSFBayEFA>();
+#endif
+#ifdef FAHRPLAN_BACKEND_IRELAND_EFA
+    list << parserInfo<ParserIrelandEFA>();
+#endif
+#ifdef FAHRPLAN_BACKEND_DUBAI_EFA
+    list << parserInfo<ParserDubaiEFA>();
+#endif
+#ifdef FAHRPLAN_BACKEND_NINETWO
+    list << parserInfo<ParserNinetwo>();
+#endif
+#ifdef FAHRPLAN_BACKEND_MUNICH_EFA
+    list << parserInfo<ParserMunichEFA>();
+#endif
+#ifdef FAHRPLAN_BACKEND_SALZBURG_EFA
+    list << parserInfo<ParserSalzburgEFA>();
+#endif
+#ifdef FAHRPLAN_BACKEND_RESROBOT
+    list << parserInfo<ParserResRobot>();
+#endif
+
+    return list;
+}
+
+const QList<ParserInfo> &ParserRegistry::backends()
+{
+    static const QList<ParserInfo> list = buildBackendList();
+    return list;
+}
+
+int ParserRegistry::count()
+{
+    return backends().count();
+}
+
+const ParserInfo &ParserRegistry::info(int index)
+{
+    const QList<ParserInfo> &list = backends();
+    Q_ASSERT_X(!list.isEmpty(), "ParserRegistry", "No backend built, check FAHRPLAN_BACKENDS");
+    if (index < 0 || index >= list.count())
+        index = 0;
+    return list.at(index);
+}
+
+ParserAbstract *ParserRegistry::create(int index)
+{
+    return info(index).create();
+}
+
+int ParserRegistry::indexOf(const QString &uid)
+{
+    const QList<ParserInfo> &list = backends();
+    for (int i = 0; i < list.count(); ++i) {
+        if (uid == QLatin1String(list.at(i).uid))
+            return i;
+    }
+    return -1;
+}
+
+QStringList ParserRegistry::names()
+{
+    QStringList result;
+    foreach (const ParserInfo &info, backends())
+        result << info.name();
+    return result;
+}
@@ -0,0 +1,87 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef PARSER_REGISTRY_H
+#define PARSER_REGISTRY_H
+
+#include "parser_abstract.h"
+
+/**
+ * @brief Static description of a backend.
+ * Everything in here is known at compile time, creating the parser is
+ * only needed to actually talk to the backend.
+ */
+struct ParserInfo
+{
+    QString (*name)();
+    QString (*shortName)();
+    const char *uid;
+    int capabilities;
+    QStringList (*trainRestrictions)();
+    ParserAbstract *(*create)();
+
+    bool supportsGps() const { return capabilities & ParserAbstract::SupportsGps; }
+    bool supportsVia() const { return capabilities & ParserAbstract::SupportsVia; }
+    bool supportsTimeTable() const { return capabilities & ParserAbstract::SupportsTimeTable; }
+    bool supportsTimeTableDirection() const { return capabilities & ParserAbstract::SupportsTimeTableDirection; }
+};
+
+template <class T>
+ParserAbstract *createParser()
+{
+    return new T();
+}
+
+// Collects the static descriptions of T, the lookups pick up whatever T or
+// the nearest of its base classes declares, just like the virtual calls.
+template <class T>
+ParserInfo parserInfo()
+{
+    ParserInfo info = {
+        &T::getName,
+        &T::getShortName,
+        T::staticMetaObject.className(),
+        T::getCapabilities(),
+        &T::getTrainRestrictionList,
+        &createParser<T>
+    };
+    return info;
+}
+
+/**
+ * @brief The list of backends built into the application.
+ * Indexes are the ones stored in the settings. Which backends are built is
+ * chosen with the FAHRPLAN_BACKENDS qmake variable, all of them by default.
+ */
+class ParserRegistry
+{
+public:
+    static int count();
+    // Out of range indexes fall back to the first backend.
+    static const ParserInfo &info(int index);
+    static ParserAbstract *create(int index);
+    static int indexOf(const QString &uid);
+    static QStringList names();
+
+private:
+    static const QList<ParserInfo> &backends();
+};
+
+#endif // PARSER_REGISTRY_H
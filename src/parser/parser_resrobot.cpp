@@ -18,6 +18,7 @@
 ****************************************************************************/
 
 #include "parser_resrobot.h"
+#include "parser_json.h"
 
 #include <QDebug>
 #include <QNetworkReply>
@@ -87,27 +88,7 @@ ParserResRobot::ParserResRobot(QObject *parent) :
     transportModeStrings[QString::fromUtf8("Övriga tåg")] = tr("Other train");
 }
 
-bool ParserResRobot::supportsGps()
-{
-    return true;
-}
-
-bool ParserResRobot::supportsVia()
-{
-    return false;
-}
-
-bool ParserResRobot::supportsTimeTable()
-{
-    return true;
-}
-
-bool ParserResRobot::supportsTimeTableDirection()
-{
-    return false;
-}
-
-QStringList ParserResRobot::getTrainRestrictions()
+QStringList ParserResRobot::getTrainRestrictionList()
 {
     QStringList list;
     list << tr("All")
@@ -301,48 +282,40 @@ void ParserResRobot::internalSearchJourney(const Station &departureStation, cons
 
 void ParserResRobot::parseTimeTable(QNetworkReply *networkReply)
 {
-    QByteArray allData = networkReply->readAll();
-    //qDebug() << "Reply:\n" << allData;
-
-    QVariantMap doc = parseJson(allData);
-    if (doc.isEmpty()) {
+    ParserJsonDocument doc(networkReply->readAll());
+    if (!doc.root().isObject() || doc.root().count() == 0) {
         emit errorOccured(tr("Cannot parse reply from the server"));
         return;
     }
 
-    QVariantMap departuresResult= doc.value("getdeparturesresult").toMap();
-    QVariantList timetableData;
-    if (departuresResult.contains("departuresegment"))
-        timetableData = ensureList(departuresResult.value("departuresegment"));
+    QList<ParserJsonValue> timetableData = ensureList(doc.root()["getdeparturesresult"]["departuresegment"]);
 
     TimetableEntriesList timetable;
-    foreach (QVariant timetableEntryData, timetableData) {
-        QVariantMap entry = timetableEntryData.toMap();
+    foreach (const ParserJsonValue &entry, timetableData) {
         TimetableEntry resultItem;
 
-        QVariantMap departure = entry.value("departure").toMap();
-        resultItem.currentStation = departure.value("location").toMap().value("name").toString();
-        resultItem.longitude = departure.value("@x").toDouble();
-        resultItem.latitude = departure.value("@y").toDouble();
-        resultItem.platform = departure.value("stoppoint").toString();
-        resultItem.time = QDateTime::fromString(departure.value("datetime").toString(), "yyyy-MM-dd HH:mm").time();
+        ParserJsonValue departure = entry["departure"];
+        resultItem.currentStation = departure["location"]["name"].toString();
+        resultItem.longitude = departure["@x"].toDouble();
+        resultItem.latitude = departure["@y"].toDouble();
+        resultItem.platform = departure["stoppoint"].toString();
+        resultItem.time = QDateTime::fromString(departure["datetime"].toString(), "yyyy-MM-dd HH:mm").time();
 
         // Destination
-        resultItem.destinationStation = entry.value("direction").toString();
+        resultItem.destinationStation = entry["direction"].toString();
 
         // Realtime info
-        QVariantMap realtimeInfo = entry.value("realtime").toMap();
         bool hasDeviationInfo;
-        int deviation = realtimeInfo.value("departuretimedeviation").toInt(&hasDeviationInfo);
+        int deviation = entry["realtime"]["departuretimedeviation"].toInt(&hasDeviationInfo);
         if (hasDeviationInfo && deviation != 0)
             resultItem.miscInfo = tr("New time: ") + resultItem.time.addSecs(deviation * 60).toString("HH:mm");
 
         // Means of transportation
-        QVariantMap mot = entry.value("segmentid").toMap().value("mot").toMap();
-        resultItem.trainType = translateTransportMode(mot.value("#text").toString());
-        QVariantMap carrier = entry.value("segmentid").toMap().value("carrier").toMap();
-        if (carrier.size() > 0) {
-            QString carrierNumber = carrier.value("number").toString();
+        ParserJsonValue mot = entry["segmentid"]["mot"];
+        resultItem.trainType = translateTransportMode(mot["#text"].toString());
+        ParserJsonValue carrier = entry["segmentid"]["carrier"];
+        if (carrier.count() > 0) {
+            QString carrierNumber = carrier["number"].toString();
             if (!carrierNumber.isEmpty())
                 resultItem.trainType += " " + carrierNumber;
         }
@@ -354,26 +327,21 @@ void ParserResRobot::parseTimeTable(QNetworkReply *networkReply)
 
 void ParserResRobot::parseStationsByName(QNetworkReply *networkReply)
 {
-    QByteArray allData = networkReply->readAll();
-    //qDebug() << "Reply:\n" << allData;
-
-    QVariantMap doc = parseJson(allData);
-    if (doc.isEmpty()) {
+    ParserJsonDocument doc(networkReply->readAll());
+    if (!doc.root().isObject() || doc.root().count() == 0) {
         emit errorOccured(tr("Cannot parse reply from the server"));
         return;
     }
 
-    QVariantList stations = ensureList(doc.value("findlocationresult").toMap()
-                                       .value("from").toMap().value("location"));
+    QList<ParserJsonValue> stations = ensureList(doc.root()["findlocationresult"]["from"]["location"]);
 
     StationsList result;
-    foreach (QVariant stationData, stations) {
-        QVariantMap station = stationData.toMap();
+    foreach (const ParserJsonValue &station, stations) {
         Station s;
-        s.id = station.value("locationid").toString();
-        s.name = station.value("displayname").toString();
-        s.longitude = station.value("@x").toDouble();
-        s.latitude = station.value("@y").toDouble();
+        s.id = station["locationid"].toString();
+        s.name = station["displayname"].toString();
+        s.longitude = station["@x"].toDouble();
+        s.latitude = station["@y"].toDouble();
 
         // Extra filter to get rid of nonsense in results
         // Example: Searching for "Wieselgren" returns stuff like
@@ -387,25 +355,21 @@ void ParserResRobot::parseStationsByName(QNetworkReply *networkReply)
 
 void ParserResRobot::parseStationsByCoordinates(QNetworkReply *networkReply)
 {
-    QByteArray allData = networkReply->readAll();
-    //qDebug() << "Reply:\n" << allData;
-
-    QVariantMap doc = parseJson(allData);
-    if (doc.isEmpty()) {
+    ParserJsonDocument doc(networkReply->readAll());
+    if (!doc.root().isObject() || doc.root().count() == 0) {
         emit errorOccured(tr("Cannot parse reply from the server"));
         return;
     }
 
-    QVariantList stations = ensureList(doc.value("stationsinzoneresult").toMap().value("location"));
+    QList<ParserJsonValue> stations = ensureList(doc.root()["stationsinzoneresult"]["location"]);
 
     StationsList result;
-    foreach (QVariant stationData, stations) {
-        QVariantMap station = stationData.toMap();
+    foreach (const ParserJsonValue &station, stations) {
         Station s;
-        s.id = station.value("@id").toString();
-        s.name = station.value("name").toString();
-        s.longitude = station.value("@x").toDouble();
-        s.latitude = station.value("@y").toDouble();
+        s.id = station["@id"].toString();
+        s.name = station["name"].toString();
+        s.longitude = station["@x"].toDouble();
+        s.latitude = station["@y"].toDouble();
         result.append(s);
     }
 
@@ -414,28 +378,23 @@ void ParserResRobot::parseStationsByCoordinates(QNetworkReply *networkReply)
 
 void ParserResRobot::parseSearchJourney(QNetworkReply *networkReply)
 {
-    QByteArray allData = networkReply->readAll();
-    //qDebug() << "Reply:\n" << allData;
-
-    QVariantMap doc = parseJson(allData);
-    if (doc.isEmpty()) {
+    ParserJsonDocument doc(networkReply->readAll());
+    if (!doc.root().isObject() || doc.root().count() == 0) {
         emit errorOccured(tr("Cannot parse reply from the server"));
         return;
     }
 
-    QVariantMap timetableResult = doc.value("timetableresult").toMap();
-    QVariantList journeyListData;
-    if (timetableResult.contains("ttitem"))
-        journeyListData = ensureList(timetableResult.value("ttitem"));
+    QList<ParserJsonValue> journeyListData = ensureList(doc.root()["timetableresult"]["ttitem"]);
 
+    beginResultScope();
     cachedResults.clear();
 
-    JourneyResultList *journeyList = new JourneyResultList();
+    JourneyResultList *journeyList = adoptResult(new JourneyResultList());
 
     int journeyCounter = 0;
-    foreach (QVariant journeyData, journeyListData) {
+    foreach (const ParserJsonValue &journeyData, journeyListData) {
         QString journeyID = QString::number(journeyCounter);
-        QList<JourneyDetailResultItem*> segments = parseJourneySegments(journeyData.toMap());
+        QList<JourneyDetailResultItem*> segments = parseJourneySegments(journeyData);
         if (segments.isEmpty())
             continue;
 
@@ -454,7 +413,7 @@ void ParserResRobot::parseSearchJourney(QNetworkReply *networkReply)
         if (transportModes.count() == 0 && segments.count() == 1)
             transportModes.append(segments.first()->train());
 
-        JourneyDetailResultList* journeyDetails = new JourneyDetailResultList;
+        JourneyDetailResultList* journeyDetails = adoptResult(new JourneyDetailResultList);
         foreach (JourneyDetailResultItem* segment, segments)
             journeyDetails->appendItem(segment);
         journeyDetails->setId(journeyID);
@@ -484,10 +443,13 @@ void ParserResRobot::parseSearchJourney(QNetworkReply *networkReply)
         journey->setDate(segments.first()->departureDateTime().date());
         journey->setDepartureTime(depTime);
         journey->setArrivalTime(arrTime);
+        journey->setDepartureDateTime(journeyDetails->departureDateTime());
+        journey->setArrivalDateTime(journeyDetails->arrivalDateTime());
         journey->setTrainType(transportModes.join(", "));
         journey->setDuration(duration);
         journey->setTransfers(QString::number(transportModes.count()-1));
         journeyList->appendItem(journey);
+        delete journey;
 
         if (journeyCounter == 0) {
             if (lastJourneySearch.mode == Departure)
@@ -515,53 +477,52 @@ void ParserResRobot::parseSearchJourney(QNetworkReply *networkReply)
 }
 
 // Parse info about one journey option. Store detailed info about segments for later use.
-QList<JourneyDetailResultItem*> ParserResRobot::parseJourneySegments(const QVariantMap &journeyData)
+QList<JourneyDetailResultItem*> ParserResRobot::parseJourneySegments(const ParserJsonValue &journeyData)
 {
     QList<JourneyDetailResultItem*> results;
 
-    QVariantList segments = ensureList(journeyData.value("segment"));
-    foreach (QVariant segmentData, segments)
+    QList<ParserJsonValue> segments = ensureList(journeyData["segment"]);
+    foreach (const ParserJsonValue &segment, segments)
     {
-        QVariantMap segment = segmentData.toMap();
         JourneyDetailResultItem* resultItem = new JourneyDetailResultItem;
 
         // Departure
-        QVariantMap departure = segment.value("departure").toMap();
-        resultItem->setDepartureStation(departure.value("location").toMap().value("name").toString());
-        resultItem->setDepartureDateTime(QDateTime::fromString(departure.value("datetime").toString(), "yyyy-MM-dd HH:mm"));
+        ParserJsonValue departure = segment["departure"];
+        resultItem->setDepartureStation(departure["location"]["name"].toString());
+        resultItem->setDepartureDateTime(QDateTime::fromString(departure["datetime"].toString(), "yyyy-MM-dd HH:mm"));
 
         // Arrival
-        QVariantMap arrival = segment.value("arrival").toMap();
-        resultItem->setArrivalStation(arrival.value("location").toMap().value("name").toString());
-        resultItem->setArrivalDateTime(QDateTime::fromString(arrival.value("datetime").toString(), "yyyy-MM-dd HH:mm"));
+        ParserJsonValue arrival = segment["arrival"];
+        resultItem->setArrivalStation(arrival["location"]["name"].toString());
+        resultItem->setArrivalDateTime(QDateTime::fromString(arrival["datetime"].toString(), "yyyy-MM-dd HH:mm"));
 
 
         QStringList info;
 
         // Remarks
         if (segment.contains("remarks")) {
-            QVariantList remarks = ensureList(segment.value("remarks").toMap().value("remark"));
-            foreach (QVariant remark, remarks)
-                info.append(translateRemark(remark.toMap().value("#text").toString()));
+            QList<ParserJsonValue> remarks = ensureList(segment["remarks"]["remark"]);
+            foreach (const ParserJsonValue &remark, remarks)
+                info.append(translateRemark(remark["#text"].toString()));
         }
 
         // Means of transportation
-        QVariantMap mot = segment.value("segmentid").toMap().value("mot").toMap();
-        QString type = mot.value("@type").toString();
-        QString motName = translateTransportMode(mot.value("#text").toString());
+        ParserJsonValue mot = segment["segmentid"]["mot"];
+        QString type = mot["@type"].toString();
+        QString motName = translateTransportMode(mot["#text"].toString());
         QString distance;
         if (type == "G" || type == "GL") { // Walk or long walk
-            distance = segment.value("segmentid").toMap().value("distance").toString();
+            distance = segment["segmentid"]["distance"].toString();
             resultItem->setInternalData1("WALK");
         }
-        QVariantMap carrier = segment.value("segmentid").toMap().value("carrier").toMap();
+        ParserJsonValue carrier = segment["segmentid"]["carrier"];
         QString carrierInfo;
-        if (carrier.size() > 0) {
-            QString carrierNumber = carrier.value("number").toString();
+        if (carrier.count() > 0) {
+            QString carrierNumber = carrier["number"].toString();
             if (!carrierNumber.isEmpty())
                 motName += " " + carrierNumber;
-            QString carrierName = carrier.value("name").toString();
-            QString carrierURL = carrier.value("url").toString();
+            QString carrierName = carrier["name"].toString();
+            QString carrierURL = carrier["url"].toString();
             if (!carrierName.isEmpty()) {
                 if (carrierURL.isEmpty())
                     carrierInfo = carrierName;
@@ -579,7 +540,7 @@ QList<JourneyDetailResultItem*> ParserResRobot::parseJourneySegments(const QVari
             resultItem->setInfo(carrierInfo);
         else if (!info.isEmpty())
             resultItem->setInfo(info.join(", "));
-        resultItem->setDirection(segment.value("direction").toString());
+        resultItem->setDirection(segment["direction"].toString());
 
         results.append(resultItem);
     }
@@ -627,15 +588,16 @@ void ParserResRobot::parseJourneyDetails(QNetworkReply *networkReply)
 
 // If a list only contains one item, the API skips the list and sets the list variable
 // to the item directly. This function ensures that the variable always is a list.
-QVariantList ParserResRobot::ensureList(const QVariant &variable)
+QList<ParserJsonValue> ParserResRobot::ensureList(const ParserJsonValue &variable)
 {
-    if (variable.type() == QVariant::List) {
-        return variable.toList();
-    } else {
-        QVariantList list;
+    QList<ParserJsonValue> list;
+    if (variable.isArray()) {
+        for (ParserJsonValue item = variable.first(); item.isValid(); item = item.next())
+            list.append(item);
+    } else if (!variable.isNull()) {
         list.append(variable);
-        return list;
     }
+    return list;
 }
 
 QString ParserResRobot::translateRemark(const QString& original)
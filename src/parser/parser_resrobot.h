@@ -22,9 +22,10 @@
 
 #include "parser_abstract.h"
 
-#include <QVariantMap>
 #include <QHash>
 
+class ParserJsonValue;
+
 /*
  * Some info on this API:
  *   * ResRobot enables searching for public transport connections in all of Sweden.
@@ -63,14 +64,14 @@ public:
 
     static QString getName() { return QString("%1 (resrobot.se)").arg(tr("Sweden")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "resrobot.se"; }
+    static QString getShortName() { return "resrobot.se"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
+    static int getCapabilities() { return SupportsGps | SupportsTimeTable; }
+    virtual int capabilities() { return getCapabilities(); }
 
 public slots:
-    virtual bool supportsGps();
-    virtual bool supportsVia();
-    virtual bool supportsTimeTable();
-    virtual bool supportsTimeTableDirection();
-    virtual QStringList getTrainRestrictions();
+    virtual QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
     virtual void findStationsByName(const QString &stationName);
     virtual void findStationsByCoordinates(qreal longitude, qreal latitude);
     virtual void getTimeTableForStation(const Station &currentStation,
@@ -133,8 +134,8 @@ private:
     virtual void internalSearchJourney(const Station &departureStation, const Station &viaStation,
                                        const Station &arrivalStation, const QDateTime &dateTime,
                                        ParserAbstract::Mode mode, int trainrestrictions);
-    QList<JourneyDetailResultItem*> parseJourneySegments(const QVariantMap &journeyData);
-    QVariantList ensureList(const QVariant &variable);
+    QList<JourneyDetailResultItem*> parseJourneySegments(const ParserJsonValue &journeyData);
+    QList<ParserJsonValue> ensureList(const ParserJsonValue &variable);
     QString translateRemark(const QString& original);
     QString translateTransportMode(QString original);
 };
@@ -31,7 +31,7 @@ ParserSalzburgEFA::ParserSalzburgEFA(QObject *parent) :
     acceptEncoding = "gzip";
 }
 
-QStringList ParserSalzburgEFA::getTrainRestrictions()
+QStringList ParserSalzburgEFA::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
@@ -30,10 +30,12 @@ public:
     explicit ParserSalzburgEFA(QObject *parent = 0);
     static QString getName() { return QString("%1, %2 (svv-info.at)").arg(tr("Austria"), tr("Salzburg")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "svv-info.at"; }
+    static QString getShortName() { return "svv-info.at"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 };
 
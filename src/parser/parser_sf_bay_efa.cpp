@@ -38,7 +38,7 @@ ParserSFBayEFA::ParserSFBayEFA(QObject *parent) :
 }
 
 
-QStringList ParserSFBayEFA::getTrainRestrictions()
+QStringList ParserSFBayEFA::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
@@ -30,10 +30,12 @@ public:
     explicit ParserSFBayEFA(QObject *parent = 0);
     static QString getName() { return QString("%1, %2 (511.org)").arg(tr("USA"), tr("SF Bay")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "511.org"; }
+    static QString getShortName() { return "511.org"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 };
 
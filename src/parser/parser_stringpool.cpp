@@ -0,0 +1,107 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "parser_stringpool.h"
+
+ParserStringPool::ParserStringPool(int maxSize)
+    : m_maxSize(maxSize)
+{
+}
+
+QString ParserStringPool::intern(const QString &text)
+{
+    if (text.isEmpty())
+        return QString();
+
+    QSet<QString>::const_iterator it = m_strings.constFind(text);
+    if (it != m_strings.constEnd())
+        return *it;
+
+    if (m_strings.count() >= m_maxSize)
+        m_strings.clear();
+    m_strings.insert(text);
+    return text;
+}
+
+QVariant ParserStringPool::intern(const QVariant &value)
+{
+    if (value.type() != QVariant::String)
+        return value;
+    return QVariant(intern(value.toString()));
+}
+
+void ParserStringPool::intern(Station &station)
+{
+    station.id = intern(station.id);
+    station.name = intern(station.name);
+    station.type = intern(station.type);
+    station.miscInfo = intern(station.miscInfo);
+}
+
+void ParserStringPool::intern(StationsList &stations)
+{
+    for (int i = 0; i < stations.count(); ++i)
+        intern(stations[i]);
+}
+
+void ParserStringPool::intern(TimetableEntry &entry)
+{
+    entry.currentStation = intern(entry.currentStation);
+    entry.destinationStation = intern(entry.destinationStation);
+    entry.trainType = intern(entry.trainType);
+    entry.platform = intern(entry.platform);
+    entry.miscInfo = intern(entry.miscInfo);
+}
+
+void ParserStringPool::intern(TimetableEntriesList &entries)
+{
+    for (int i = 0; i < entries.count(); ++i)
+        intern(entries[i]);
+}
+
+void ParserStringPool::intern(JourneyResultList *journeys)
+{
+    // Train types and infos are already interned by the list itself.
+    journeys->setDepartureStation(intern(journeys->departureStation()));
+    journeys->setViaStation(intern(journeys->viaStation()));
+    journeys->setArrivalStation(intern(journeys->arrivalStation()));
+}
+
+void ParserStringPool::intern(JourneyDetailResultList *details)
+{
+    details->setDepartureStation(intern(details->departureStation()));
+    details->setViaStation(intern(details->viaStation()));
+    details->setArrivalStation(intern(details->arrivalStation()));
+
+    for (int i = 0; i < details->itemcount(); ++i) {
+        JourneyDetailResultItem *item = details->getItem(i);
+        item->setDepartureStation(intern(item->departureStation()));
+        item->setDepartureInfo(intern(item->departureInfo()));
+        item->setArrivalStation(intern(item->arrivalStation()));
+        item->setArrivalInfo(intern(item->arrivalInfo()));
+        item->setTrain(intern(item->train()));
+        item->setDirection(intern(item->direction()));
+        item->setInfo(intern(item->info()));
+    }
+}
+
+void ParserStringPool::clear()
+{
+    m_strings.clear();
+}
@@ -0,0 +1,59 @@
+/****************************************************************************
+**
+**  This file is a part of Fahrplan.
+**
+**  This program is free software; you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation; either version 2 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License along
+**  with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef PARSER_STRINGPOOL_H
+#define PARSER_STRINGPOOL_H
+
+#include "parser_definitions.h"
+
+#include <QSet>
+
+/**
+ * @brief Interns the strings of one parser session.
+ * Station names, line names, platforms and the like repeat a lot between
+ * results. Passing them through the pool makes equal strings share one
+ * buffer, so they are stored once and compare by pointer.
+ * The pool is not thread safe, it is meant to be used by one parser at a
+ * time. Once it grows too big it is simply dropped; strings handed out
+ * before stay valid.
+ */
+class ParserStringPool
+{
+public:
+    explicit ParserStringPool(int maxSize = 4096);
+
+    QString intern(const QString &text);
+    QVariant intern(const QVariant &value);
+
+    void intern(Station &station);
+    void intern(StationsList &stations);
+    void intern(TimetableEntry &entry);
+    void intern(TimetableEntriesList &entries);
+    void intern(JourneyResultList *journeys);
+    void intern(JourneyDetailResultList *details);
+
+    int count() const { return m_strings.count(); }
+    void clear();
+
+private:
+    QSet<QString> m_strings;
+    int m_maxSize;
+};
+
+#endif // PARSER_STRINGPOOL_H
@@ -39,7 +39,7 @@ ParserSydneyEFA::ParserSydneyEFA(QObject *parent) :
 }
 
 
-QStringList ParserSydneyEFA::getTrainRestrictions()
+QStringList ParserSydneyEFA::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All, except School Buses"));
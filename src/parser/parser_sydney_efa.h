@@ -30,10 +30,12 @@ public:
     explicit ParserSydneyEFA(QObject *parent = 0);
     static QString getName() { return QString("%1, %2 (transportnsw.info)").arg(tr("Australia"), tr("Sydney")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "transportnsw.info"; }
+    static QString getShortName() { return "transportnsw.info"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
 
 };
 
@@ -28,7 +28,7 @@ ParserXmlNri::ParserXmlNri(QObject *parent) :
     STTableMode = 1;
 }
 
-QStringList ParserXmlNri::getTrainRestrictions()
+QStringList ParserXmlNri::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
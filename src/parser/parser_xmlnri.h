@@ -30,10 +30,15 @@ public:
     explicit ParserXmlNri(QObject *parent = 0);
     static QString getName() { return QString("%1 (reiseinfo.no / nri)").arg(tr("Norway")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "reiseinfo.no"; }
+    static QString getShortName() { return "reiseinfo.no"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
+    // STTableMode 1 can not filter by direction.
+    static int getCapabilities() { return SupportsGps | SupportsVia | SupportsTimeTable; }
+    virtual int capabilities() { return getCapabilities(); }
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
     QString getTrainRestrictionsCodes(int trainrestrictions);
 };
 
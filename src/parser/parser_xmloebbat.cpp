@@ -29,7 +29,7 @@ ParserXmlOebbAt::ParserXmlOebbAt(QObject *parent)
     STTableMode = 1;
 }
 
-QStringList ParserXmlOebbAt::getTrainRestrictions()
+QStringList ParserXmlOebbAt::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
@@ -47,7 +47,7 @@ QString ParserXmlRejseplanenDk::getTrainRestrictionsCodes(int trainrestrictions)
     return trainrestr;
 }
 
-QStringList ParserXmlRejseplanenDk::getTrainRestrictions()
+QStringList ParserXmlRejseplanenDk::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
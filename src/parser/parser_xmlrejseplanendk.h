@@ -30,10 +30,15 @@ public:
     explicit ParserXmlRejseplanenDk(QObject *parent = 0);
     static QString getName() { return QString("%1 (rejseplanen.dk)").arg(tr("Denmark")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "rejseplanen.dk"; }
+    static QString getShortName() { return "rejseplanen.dk"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
+    // STTableMode 1 can not filter by direction.
+    static int getCapabilities() { return SupportsGps | SupportsVia | SupportsTimeTable; }
+    virtual int capabilities() { return getCapabilities(); }
 
 protected:
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
     QString getTrainRestrictionsCodes(int trainrestrictions);
 };
 
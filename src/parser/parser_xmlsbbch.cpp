@@ -52,7 +52,7 @@ QString ParserXmlSbbCh::getTrainRestrictionsCodes(int trainrestrictions)
     return trainrestr;
 }
 
-QStringList ParserXmlSbbCh::getTrainRestrictions()
+QStringList ParserXmlSbbCh::getTrainRestrictionList()
 {
     QStringList result;
     result.append(tr("All"));
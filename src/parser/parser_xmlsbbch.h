@@ -30,11 +30,13 @@ public:
     explicit ParserXmlSbbCh(QObject *parent = 0);
     static QString getName() { return QString("%1 (sbb.ch)").arg(tr("Switzerland")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "sbb.ch"; }
+    static QString getShortName() { return "sbb.ch"; }
+    virtual QString shortName() { return getShortName(); }
+    static QStringList getTrainRestrictionList();
 
 protected:
     void parseStationsByName(QNetworkReply *networkReply);
-    QStringList getTrainRestrictions();
+    QStringList getTrainRestrictions() { return getTrainRestrictionList(); }
     QString getTrainRestrictionsCodes(int trainrestrictions);
 };
 
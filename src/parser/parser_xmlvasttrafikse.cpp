@@ -192,26 +192,6 @@ void ParserXmlVasttrafikSe::getJourneyDetails(const QString &id)
     emit journeyDetailsResult(cachedJourneyDetails.value(id, NULL));
 }
 
-bool ParserXmlVasttrafikSe::supportsGps()
-{
-    return true;
-}
-
-bool ParserXmlVasttrafikSe::supportsVia()
-{
-    return true;
-}
-
-bool ParserXmlVasttrafikSe::supportsTimeTable()
-{
-    return true;
-}
-
-bool ParserXmlVasttrafikSe::supportsTimeTableDirection()
-{
-    return false;
-}
-
 void ParserXmlVasttrafikSe::parseStationsByName(QNetworkReply *networkReply)
 {
     qDebug() << "ParserXmlVasttrafikSe::parseStationsByName(networkReply.url()=" << networkReply->url().toString() << ")";
@@ -305,13 +285,11 @@ void ParserXmlVasttrafikSe::parseSearchJourney(QNetworkReply *networkReply)
 {
     qDebug() << "ParserXmlVasttrafikSe::parseSearchJourney(networkReply.url()=" << networkReply->url().toString() << ")";
 
-    JourneyResultList *journeyResultList = new JourneyResultList();
+    beginResultScope();
+    JourneyResultList *journeyResultList = adoptResult(new JourneyResultList());
 
-    for (QHash<QString, JourneyDetailResultList *>::Iterator it = cachedJourneyDetails.begin(); it != cachedJourneyDetails.end();) {
-        JourneyDetailResultList *jdrl = it.value();
-        it = cachedJourneyDetails.erase(it);
-        delete jdrl;
-    }
+    // The details belong to the result scope of their search.
+    cachedJourneyDetails.clear();
 
     /// Use fallback values for empty results (i.e. no connections found)
     journeyResultList->setDepartureStation(m_searchJourneyParameters.departureStation.name);
@@ -330,7 +308,7 @@ void ParserXmlVasttrafikSe::parseSearchJourney(QNetworkReply *networkReply)
         QDomNodeList tripNodeList = doc.elementsByTagName("Trip");
         for (unsigned int i = 0; i < tripNodeList.length(); ++i) {
             JourneyResultItem *jritem = new JourneyResultItem();
-            JourneyDetailResultList *detailsList = new JourneyDetailResultList();
+            JourneyDetailResultList *detailsList = adoptResult(new JourneyDetailResultList());
 
             /// Set default values for journey's start and end time
             QDateTime journeyStart = QDateTime::currentDateTime();
@@ -430,6 +408,8 @@ void ParserXmlVasttrafikSe::parseSearchJourney(QNetworkReply *networkReply)
             const QString timeFormat = QLocale().timeFormat(QLocale::ShortFormat);
             jritem->setDepartureTime(journeyStart.time().toString(timeFormat));
             jritem->setArrivalTime(journeyEnd.time().toString(timeFormat));
+            jritem->setDepartureDateTime(journeyStart);
+            jritem->setArrivalDateTime(journeyEnd);
             int diffTime = journeyStart.secsTo(journeyEnd);
             if (diffTime < 0) diffTime += 86400;
             jritem->setDuration(tr("%1:%2").arg(diffTime / 3600).arg(QString::number(diffTime / 60 % 60), 2, '0'));
@@ -441,8 +421,6 @@ void ParserXmlVasttrafikSe::parseSearchJourney(QNetworkReply *networkReply)
             else if (tripRtStatus == TRIP_RTDATA_ONTIME)
                 jritem->setMiscInfo(tr("<span style=\"color:#093; font-weight: normal;\">on time</span>"));
 
-            journeyResultList->appendItem(jritem);
-
             const QString id = QString::number(i);
             jritem->setId(id);
             detailsList->setId(id);
@@ -454,6 +432,9 @@ void ParserXmlVasttrafikSe::parseSearchJourney(QNetworkReply *networkReply)
             detailsList->setDepartureDateTime(journeyStart);
             cachedJourneyDetails[id] = detailsList;
 
+            journeyResultList->appendItem(jritem);
+            delete jritem;
+
             if (!m_earliestArrival.isValid() || journeyEnd < m_earliestArrival)
                 m_earliestArrival = journeyEnd.addSecs(-60);
             if (!m_latestResultDeparture.isValid() || journeyStart > m_latestResultDeparture)
@@ -469,7 +450,7 @@ void ParserXmlVasttrafikSe::searchJourneyLater()
     if (m_latestResultDeparture.isValid())
         searchJourney(m_searchJourneyParameters.departureStation, m_searchJourneyParameters.arrivalStation, m_searchJourneyParameters.viaStation, m_latestResultDeparture, Departure, 0);
     else {
-        JourneyResultList *journeyResultList = new JourneyResultList();
+        JourneyResultList *journeyResultList = adoptResult(new JourneyResultList());
         journeyResultList->setDepartureStation(m_searchJourneyParameters.departureStation.name);
         journeyResultList->setViaStation(m_searchJourneyParameters.viaStation.name);
         journeyResultList->setArrivalStation(m_searchJourneyParameters.arrivalStation.name);
@@ -484,7 +465,7 @@ void ParserXmlVasttrafikSe::searchJourneyEarlier()
     if (m_earliestArrival.isValid())
         searchJourney(m_searchJourneyParameters.departureStation, m_searchJourneyParameters.arrivalStation, m_searchJourneyParameters.viaStation, m_earliestArrival, Arrival, 0);
     else {
-        JourneyResultList *journeyResultList = new JourneyResultList();
+        JourneyResultList *journeyResultList = adoptResult(new JourneyResultList());
         journeyResultList->setDepartureStation(m_searchJourneyParameters.departureStation.name);
         journeyResultList->setViaStation(m_searchJourneyParameters.viaStation.name);
         journeyResultList->setArrivalStation(m_searchJourneyParameters.arrivalStation.name);
@@ -30,7 +30,10 @@ public:
     explicit ParserXmlVasttrafikSe(QObject *parent = 0);
     static QString getName() { return QString("%1 (vasttrafik.se)").arg(tr("Sweden")); }
     virtual QString name() { return getName(); }
-    virtual QString shortName() { return "vasttrafik.se"; }
+    static QString getShortName() { return "vasttrafik.se"; }
+    virtual QString shortName() { return getShortName(); }
+    static int getCapabilities() { return SupportsGps | SupportsVia | SupportsTimeTable; }
+    virtual int capabilities() { return getCapabilities(); }
 
 public slots:
     virtual void getTimeTableForStation(const Station &currentStation, const Station &directionStation, const QDateTime &dateTime, Mode mode, int trainrestrictions);
@@ -40,10 +43,6 @@ public slots:
     virtual void searchJourneyLater();
     virtual void searchJourneyEarlier();
     virtual void getJourneyDetails(const QString &id);
-    virtual bool supportsGps();
-    virtual bool supportsVia();
-    virtual bool supportsTimeTable();
-    virtual bool supportsTimeTableDirection();
 //     virtual QStringList getTrainRestrictions();
 //     void cancelRequest();
 